@@ -3,96 +3,175 @@
 
 #include <mbgl/util/noncopyable.hpp>
 #include <mbgl/util/rect.hpp>
+#include <algorithm>
 #include <cstdint>
-#include <list>
+#include <vector>
 
 namespace mbgl {
 
+// Packs rectangles into shelves: horizontal rows that are as high as the first rectangle that
+// opened them. Glyphs and icons of a similar height share a shelf, so the free space of a shelf
+// is a list of horizontal segments that merge again when neighboring rectangles are released.
+// Once a shelf is empty, it is merged with empty shelves above and below, so that the space can
+// be reused for rectangles of any height.
 template <typename T>
 class BinPack : private util::noncopyable {
 public:
-    BinPack(T width, T height)
-        : free(1, Rect<uint16_t>{ 0, 0, width, height }) {}
+    BinPack(T width_, T height_)
+        : width(width_), height(height_) {}
+
 public:
-    Rect<T> allocate(T width, T height) {
-        // Find the smallest free rect angle
-        auto smallest = free.end();
-        for (auto it = free.begin(); it != free.end(); ++it) {
-            const Rect<T>& ref = *it;
-            const Rect<T>& rect = *smallest;
-            if (width <= ref.w && height <= ref.h) {
-                if (smallest == free.end() || (ref.y <= rect.y && ref.x <= rect.x)) {
-                    smallest = it;
+    Rect<T> allocate(T w, T h) {
+        if (w == 0 || h == 0 || w > width) {
+            return Rect<T>{ 0, 0, 0, 0 };
+        }
+
+        // Prefer the lowest shelf that fits the rectangle without wasting more than half of its
+        // height. Otherwise, split an empty shelf, open a new shelf at the top, or settle for
+        // any shelf that is high enough, in that order.
+        auto best = shelves.end();
+        auto empty = shelves.end();
+        auto fallback = shelves.end();
+        for (auto it = shelves.begin(); it != shelves.end(); ++it) {
+            if (it->h < h) {
+                continue;
+            }
+            if (it->isEmpty(width)) {
+                if (empty == shelves.end() || it->h < empty->h) {
+                    empty = it;
+                }
+            } else if (it->find(w) != it->free.end()) {
+                if (it->h <= h + h / 2) {
+                    if (best == shelves.end() || it->h < best->h) {
+                        best = it;
+                    }
+                } else if (fallback == shelves.end() || it->h < fallback->h) {
+                    fallback = it;
                 }
             }
         }
 
-        if (smallest == free.end()) {
-            // There's no space left for this char.
-            return Rect<uint16_t>{ 0, 0, 0, 0 };
-        } else {
-            Rect<T> rect = *smallest;
-            free.erase(smallest);
-
-            // Shorter/Longer Axis Split Rule (SAS)
-            // http://clb.demon.fi/files/RectangleBinPack.pdf p. 15
-            // Ignore the dimension of R and just split long the shorter dimension
-            // See Also: http://www.cs.princeton.edu/~chazelle/pubs/blbinpacking.pdf
-            if (rect.w < rect.h) {
-                // split horizontally
-                // +--+---+
-                // |__|___|  <-- b1
-                // +------+  <-- b2
-                if (rect.w > width) free.emplace_back(rect.x + width, rect.y, rect.w - width, height);
-                if (rect.h > height) free.emplace_back(rect.x, rect.y + height, rect.w, rect.h - height);
-            } else {
-                // split vertically
-                // +--+---+
-                // |__|   | <-- b1
-                // +--|---+ <-- b2
-                if (rect.w > width) free.emplace_back(rect.x + width, rect.y, rect.w - width, rect.h);
-                if (rect.h > height) free.emplace_back(rect.x, rect.y + height, width, rect.h - height);
+        if (best != shelves.end()) {
+            return best->allocate(w, h);
+        }
+
+        if (empty != shelves.end()) {
+            if (empty->h > h) {
+                const T y = empty->y;
+                empty->y += h;
+                empty->h -= h;
+                empty = shelves.emplace(empty, y, h, width);
             }
+            return empty->allocate(w, h);
+        }
 
-            return Rect<uint16_t>{ rect.x, rect.y, width, height };
+        const T top = shelves.empty() ? 0 : shelves.back().y + shelves.back().h;
+        if (height - top >= h) {
+            shelves.emplace_back(top, h, width);
+            return shelves.back().allocate(w, h);
+        }
+
+        if (fallback != shelves.end()) {
+            return fallback->allocate(w, h);
         }
-    }
 
+        // There's no space left for this rectangle.
+        return Rect<T>{ 0, 0, 0, 0 };
+    }
 
     void release(Rect<T> rect) {
-        // Simple algorithm to recursively merge the newly released cell with its
-        // neighbor. This doesn't merge more than two cells at a time, and fails
-        // for complicated merges.
-        for (auto it = free.begin(); it != free.end(); ++it) {
-            Rect<T> ref = *it;
-            if (ref.y == rect.y && ref.h == rect.h && ref.x + ref.w == rect.x) {
-                ref.w += rect.w;
-            }
-            else if (ref.x == rect.x && ref.w == rect.w && ref.y + ref.h == rect.y) {
-                ref.h += rect.h;
-            }
-            else if (rect.y == ref.y && rect.h == ref.h && rect.x + rect.w == ref.x) {
-                ref.x = rect.x;
-                ref.w += rect.w;
-            }
-            else if (rect.x == ref.x && rect.w == ref.w && rect.y + rect.h == ref.y) {
-                ref.y = rect.y;
-                ref.h += rect.h;
-            } else {
-                continue;
-            }
+        auto shelf = std::lower_bound(shelves.begin(), shelves.end(), rect.y,
+                                      [](const Shelf &s, T y) { return s.y < y; });
+        if (shelf == shelves.end() || shelf->y != rect.y || rect.w == 0) {
+            return;
+        }
 
-            free.erase(it);
-            release(ref);
+        shelf->release(rect.x, rect.w);
+        if (!shelf->isEmpty(width)) {
             return;
+        }
+
+        auto next = shelf + 1;
+        if (next != shelves.end() && next->isEmpty(width)) {
+            shelf->h += next->h;
+            shelf = shelves.erase(next) - 1;
+        }
+        if (shelf != shelves.begin() && (shelf - 1)->isEmpty(width)) {
+            (shelf - 1)->h += shelf->h;
+            shelves.erase(shelf);
+        }
 
+        // Space above the last used shelf can be used for a new shelf of any height.
+        while (!shelves.empty() && shelves.back().isEmpty(width)) {
+            shelves.pop_back();
         }
+    }
 
-        free.emplace_back(rect);
-    };
+    // Makes the rows between the current and the new height available.
+    void grow(T height_) {
+        height = std::max(height, height_);
+    }
 
 private:
-    std::list<Rect<T>> free;
+    // A horizontal run of free space within a shelf.
+    struct Segment {
+        T x;
+        T w;
+    };
+
+    struct Shelf {
+        Shelf(T y_, T h_, T width) : y(y_), h(h_), free(1, Segment{ 0, width }) {}
+
+        T y;
+        T h;
+
+        // Sorted by x; adjacent segments are always merged.
+        std::vector<Segment> free;
+
+        bool isEmpty(T width) const {
+            return free.size() == 1 && free.front().w == width;
+        }
+
+        typename std::vector<Segment>::iterator find(T w) {
+            return std::find_if(free.begin(), free.end(),
+                                [w](const Segment &segment) { return segment.w >= w; });
+        }
+
+        Rect<T> allocate(T w, T h_) {
+            auto segment = find(w);
+            const T x = segment->x;
+            segment->x += w;
+            segment->w -= w;
+            if (segment->w == 0) {
+                free.erase(segment);
+            }
+            return Rect<T>{ x, y, w, h_ };
+        }
+
+        void release(T x, T w) {
+            auto next = std::lower_bound(free.begin(), free.end(), x,
+                                         [](const Segment &s, T x_) { return s.x < x_; });
+            if (next != free.begin() && (next - 1)->x + (next - 1)->w == x) {
+                auto prev = next - 1;
+                prev->w += w;
+                if (next != free.end() && prev->x + prev->w == next->x) {
+                    prev->w += next->w;
+                    free.erase(next);
+                }
+            } else if (next != free.end() && x + w == next->x) {
+                next->x = x;
+                next->w += w;
+            } else {
+                free.insert(next, Segment{ x, w });
+            }
+        }
+    };
+
+    T width;
+    T height;
+
+    // Sorted by y; shelves are stacked without gaps from the bottom of the bin.
+    std::vector<Shelf> shelves;
 };
 
 }
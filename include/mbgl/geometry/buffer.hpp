@@ -5,6 +5,7 @@
 #include <mbgl/util/noncopyable.hpp>
 
 #include <cstdlib>
+#include <cstring>
 #include <cassert>
 #include <stdexcept>
 
@@ -36,6 +37,11 @@ public:
         return pos == 0;
     }
 
+    // Returns the number of bytes that have been written to this buffer.
+    inline size_t bytes() const {
+        return pos;
+    }
+
     // Transfers this buffer to the GPU and binds the buffer to the GL context.
     void bind(bool force = false) {
         if (buffer == 0) {
@@ -66,6 +72,41 @@ public:
         return buffer;
     }
 
+    // Returns the bytes that have been written so far, or nullptr once the buffer was uploaded
+    // and cleaned up.
+    inline const void *data() const {
+        return array;
+    }
+
+    // Appends whole items in raw form, e.g. when restoring a serialized tile.
+    void append(const void *data_, size_t bytes) {
+        if (bytes % itemSize != 0) {
+            throw std::runtime_error("Can't append partial elements");
+        }
+        if (buffer != 0) {
+            throw std::runtime_error("Can't add elements after buffer was bound to GPU");
+        }
+        if (!bytes) {
+            return;
+        }
+        if (length < pos + bytes) {
+            while (length < pos + bytes) length += defaultLength;
+            array = realloc(array, length);
+            if (array == nullptr) {
+                throw std::runtime_error("Buffer reallocation failed");
+            }
+        }
+        std::memcpy(static_cast<char *>(array) + pos, data_, bytes);
+        pos += bytes;
+    }
+
+    // Appends the items of another buffer, starting with the item at the given index.
+    void append(const Buffer &other, size_t from = 0) {
+        if (other.pos > from * itemSize) {
+            append(static_cast<const char *>(other.array) + from * itemSize, other.pos - from * itemSize);
+        }
+    }
+
 protected:
     // increase the buffer size by at least /required/ bytes.
     inline void *addElement() {
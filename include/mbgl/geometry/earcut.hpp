@@ -0,0 +1,47 @@
+#ifndef MBGL_GEOMETRY_EARCUT
+#define MBGL_GEOMETRY_EARCUT
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <clipper/clipper.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace mbgl {
+
+// Triangulates simple polygons by ear clipping. This is a lot cheaper than running a ring
+// through a union and libtess2, but only handles a single ring without holes. The scratch
+// vectors are reused between calls, so keep an instance around.
+class Earcut : private util::noncopyable {
+public:
+    typedef ClipperLib::IntPoint Point;
+
+    // Rings with more vertices are left to the general tessellator because the simplicity
+    // check is quadratic.
+    static const size_t maxVertices = 256;
+
+    // Returns false if the ring is not simple (self-intersecting or touching itself), too large,
+    // or can't be triangulated, in which case the caller must fall back to a general
+    // tessellator. On success, vertices() holds the cleaned up ring and indices() three
+    // indices into it per triangle. Degenerate rings and rings with a negative area produce no
+    // vertices, matching a positive winding fill rule.
+    bool triangulate(const std::vector<Point> &ring);
+
+    inline const std::vector<Point> &vertices() const { return points; }
+    inline const std::vector<uint16_t> &indices() const { return triangles; }
+
+private:
+    bool isSimple() const;
+    bool isEar(uint16_t a, uint16_t b, uint16_t c) const;
+
+private:
+    std::vector<Point> points;
+    std::vector<uint16_t> triangles;
+    std::vector<uint16_t> prev;
+    std::vector<uint16_t> next;
+};
+
+}
+
+#endif
@@ -4,8 +4,10 @@
 #include <mbgl/geometry/buffer.hpp>
 #include <mbgl/geometry/vao.hpp>
 #include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/binary.hpp>
 
 #include <array>
+#include <vector>
 
 namespace mbgl {
 
@@ -27,6 +29,27 @@ struct ElementGroup : public util::noncopyable {
           elements_length(rhs.elements_length) {};
 };
 
+template <int count>
+void writeElementGroups(util::BinaryWriter &writer, const std::vector<ElementGroup<count>> &groups) {
+    writer.write<uint32_t>(groups.size());
+    for (const ElementGroup<count> &group : groups) {
+        writer.write<uint32_t>(group.vertex_length);
+        writer.write<uint32_t>(group.elements_length);
+    }
+}
+
+template <int count>
+std::vector<ElementGroup<count>> readElementGroups(util::BinaryReader &reader) {
+    std::vector<ElementGroup<count>> groups;
+    const uint32_t size = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < size; i++) {
+        const uint32_t vertex_length = reader.read<uint32_t>();
+        const uint32_t elements_length = reader.read<uint32_t>();
+        groups.emplace_back(vertex_length, elements_length);
+    }
+    return groups;
+}
+
 class TriangleElementsBuffer : public Buffer<
     6, // bytes per triangle (3 * unsigned short == 6 bytes)
     GL_ELEMENT_ARRAY_BUFFER
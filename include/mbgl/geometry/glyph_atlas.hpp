@@ -8,8 +8,10 @@
 #include <string>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <mutex>
 #include <atomic>
+#include <vector>
 
 namespace mbgl {
 
@@ -18,16 +20,21 @@ public:
 
 private:
     struct GlyphValue {
-        GlyphValue(const Rect<uint16_t>& rect_, uint64_t id)
-            : rect(rect_), ids({ id }) {}
+        GlyphValue(const Rect<uint16_t>& rect_)
+            : rect(rect_) {}
         Rect<uint16_t> rect;
-        std::set<uint64_t> ids;
+        // The number of tiles that use this glyph.
+        uint32_t refs = 0;
     };
 
+    typedef std::map<uint32_t, GlyphValue> Face;
+
     Rect<uint16_t> addGlyph_impl(uint64_t tile_id, const std::string& face_name,
                                  const SDFGlyph& glyph);
 public:
-    GlyphAtlas(uint16_t width, uint16_t height);
+    // The atlas starts out with the given size. When it is full, its height is doubled, up to
+    // maxHeight.
+    GlyphAtlas(uint16_t width, uint16_t height, uint16_t maxHeight = 4096);
     ~GlyphAtlas();
 
 
@@ -36,19 +43,37 @@ public:
     void addGlyphs(uint64_t tileid, std::u32string const& text, std::string const& stackname,
                    FontStack const& fontStack, GlyphPositions & face);
     void removeGlyphs(uint64_t tile_id);
+
+    // Binds the texture of the atlas and uploads the rows that changed since the last call.
     void bind();
 
+    // The height of the texture as of the last call to bind(). Must be called in the render thread.
+    inline uint16_t getTextureHeight() const { return textureHeight; }
+
 public:
     const uint16_t width = 0;
-    const uint16_t height = 0;
+    const uint16_t maxHeight = 0;
 
 private:
+    // Doubles the height of the atlas. Returns false if it is already at its maximum height.
+    bool grow();
+
     std::mutex mtx;
     BinPack<uint16_t> bin;
-    std::map<std::string, std::map<uint32_t, GlyphValue>> index;
-    char *const data = nullptr;
+    std::map<std::string, Face> index;
+
+    // The glyphs that each tile uses, so that removing a tile only visits those.
+    std::unordered_map<uint64_t, std::set<std::pair<Face *, uint32_t>>> tiles;
+    uint16_t height = 0;
+    std::vector<char> data;
     std::atomic<bool> dirty;
+
+    // Rows that changed since the last upload.
+    uint16_t dirtyTop = 0;
+    uint16_t dirtyBottom = 0;
+
     uint32_t texture = 0;
+    uint16_t textureHeight = 0;
 };
 
 };
@@ -7,7 +7,7 @@
 namespace mbgl {
 
 class TextVertexBuffer : public Buffer <
-    16,
+    20,
     GL_ARRAY_BUFFER,
     32768
 > {
@@ -28,6 +28,10 @@ class Texturepool;
 class FileSource;
 class View;
 
+namespace util {
+class WorkScheduler;
+}
+
 class Map : private util::noncopyable {
     typedef void (*stop_callback)(void *);
 
@@ -116,6 +120,10 @@ public:
     void startRotating();
     void stopRotating();
 
+    // Tile cache
+    void setTileCacheSize(size_t bytes);
+    size_t getTileCacheSize() const;
+
     // Debug
     void setDebug(bool value);
     void toggleDebug();
@@ -132,7 +140,7 @@ public:
     inline SpriteAtlas & getSpriteAtlas() { return spriteAtlas; }
     util::ptr<Sprite> getSprite();
     inline util::ptr<Texturepool> getTexturepool() { return texturepool; }
-    uv::worker &getWorker();
+    util::WorkScheduler &getWorker();
     inline timestamp getAnimationTime() const { return animationTime; }
     inline timestamp getTime() const { return animationTime; }
     void updateTiles();
@@ -159,7 +167,7 @@ private:
 private:
     bool async = false;
     std::unique_ptr<uv::loop> loop;
-    std::unique_ptr<uv::worker> workers;
+    std::unique_ptr<util::WorkScheduler> workers;
     std::unique_ptr<uv::thread> thread;
     std::unique_ptr<uv_async_t> async_terminate;
     std::unique_ptr<uv_async_t> async_render;
@@ -211,6 +219,9 @@ private:
     bool debug = false;
     timestamp animationTime = 0;
 
+    // Maximum number of bytes each source may use for caching parsed tiles that are not visible.
+    std::atomic<size_t> tileCacheSize { 32 * 1024 * 1024 };
+
     std::set<util::ptr<StyleSource>> activeSources;
 
 };
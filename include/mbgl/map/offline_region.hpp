@@ -0,0 +1,123 @@
+#ifndef MBGL_MAP_OFFLINE_REGION
+#define MBGL_MAP_OFFLINE_REGION
+
+#include <mbgl/storage/resource_type.hpp>
+#include <mbgl/text/glyph.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/ptr.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace mbgl {
+
+class FileSource;
+class Request;
+class Response;
+class SourceInfo;
+class SQLiteStore;
+class Style;
+
+// Downloads everything a style needs to show a region into the persistent cache and pins it,
+// so that the region can be viewed offline: the style, the TileJSON of its sources, the
+// sprite, glyph ranges for its font stacks and the tiles of all sources that the style uses.
+// Must be used in the thread of the FileSource.
+class OfflineRegion : public std::enable_shared_from_this<OfflineRegion>, private util::noncopyable {
+public:
+    struct Options {
+        std::string styleURL;
+        std::string accessToken;
+
+        // The region in degrees.
+        double west = -180, south = -85.0511, east = 180, north = 85.0511;
+
+        // Zoom levels of the tiles to download. Sources only provide tiles up to their maximum
+        // zoom level; higher zoom levels show overzoomed tiles.
+        int minZoom = 0, maxZoom = 14;
+
+        float pixelRatio = 1;
+
+        // Downloaded for every font stack the style uses. Labels with glyphs outside of these
+        // ranges are shown without those glyphs while offline.
+        std::vector<GlyphRange> glyphRanges = {{ 0, 255 }};
+
+        // Maximum number of requests in flight.
+        unsigned int concurrency = 8;
+    };
+
+    struct Progress {
+        // Includes failed resources and resources that were pinned by an earlier download.
+        uint64_t completed = 0;
+        uint64_t failed = 0;
+
+        // Grows while the style and the TileJSON of its sources are loaded.
+        uint64_t total = 0;
+
+        bool done = false;
+    };
+
+    typedef std::function<void(const Progress &)> ProgressCallback;
+
+    OfflineRegion(FileSource &fileSource, const Options &options);
+    ~OfflineRegion();
+
+    // Starts the download. Resources that are already pinned are skipped, so an interrupted
+    // download resumes where it stopped. The callback is invoked whenever a resource finished,
+    // and a last time with done set.
+    void start(ProgressCallback callback);
+
+    // Stops the download. Resources that finished downloading stay pinned.
+    void cancel();
+
+    // Returns the tiles of the region at the given zoom level.
+    std::vector<std::pair<int32_t, int32_t>> tiles(int8_t z) const;
+
+private:
+    struct Resource {
+        ResourceType type;
+        std::string url;
+    };
+
+    typedef std::function<void(const Response &)> LoadedCallback;
+
+    void load(const Resource &resource, LoadedCallback loaded);
+    void loadStyle(const Response &res);
+    void loadTileJSON(const util::ptr<SourceInfo> &info, const Response &res);
+    void addTiles(const SourceInfo &info);
+
+    // Skips resources that were seen before or are already pinned, and queues the others.
+    void add(std::vector<Resource> &&resources);
+    static void addUnpinned(std::vector<std::string> &&urls, void *ptr);
+
+    void finished(const Resource &resource, const Response &res);
+    void pump();
+    void checkDone();
+
+private:
+    FileSource &fileSource;
+    const Options options;
+    util::ptr<SQLiteStore> store;
+    ProgressCallback callback;
+    Progress progress;
+
+    std::unique_ptr<Style> style;
+    std::unordered_set<std::string> seen;
+    std::deque<Resource> queue;
+    std::list<std::unique_ptr<Request>> requests;
+
+    // Lookups of pinned resources and TileJSON requests that may still add resources.
+    unsigned int pending = 0;
+    unsigned int active = 0;
+    bool started = false;
+    bool stopped = false;
+};
+
+}
+
+#endif
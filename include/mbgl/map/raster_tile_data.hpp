@@ -22,6 +22,7 @@ public:
     virtual void parse();
     virtual void render(Painter &painter, util::ptr<StyleLayer> layer_desc, const mat4 &matrix);
     virtual bool hasData(StyleLayer const& layer_desc) const;
+    virtual size_t bytes() const;
 
 protected:
     StyleBucketRaster properties;
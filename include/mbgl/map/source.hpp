@@ -3,6 +3,7 @@
 
 #include <mbgl/map/tile.hpp>
 #include <mbgl/map/tile_data.hpp>
+#include <mbgl/map/tile_cache.hpp>
 #include <mbgl/style/style_source.hpp>
 
 #include <mbgl/util/noncopyable.hpp>
@@ -63,6 +64,9 @@ private:
 
     std::map<Tile::ID, std::unique_ptr<Tile>> tiles;
     std::map<Tile::ID, std::weak_ptr<TileData>> tile_data;
+
+    // Parsed tiles that are no longer visible, but may be reused when they come back into view.
+    TileCache cache;
 };
 
 }
@@ -10,7 +10,9 @@
 #include <iosfwd>
 #include <string>
 #include <unordered_map>
-#include <future>
+#include <functional>
+#include <mutex>
+#include <vector>
 
 namespace mbgl {
 
@@ -42,9 +44,12 @@ public:
 
     const SpritePosition &getSpritePosition(const std::string& name) const;
 
-    void waitUntilLoaded() const;
     bool isLoaded() const;
 
+    // Returns true when loading the sprite has finished (successfully or not). Otherwise, the
+    // callback is invoked in the map thread once it has finished.
+    bool isLoaded(const std::function<void()> &callback);
+
     operator bool() const;
 
 private:
@@ -60,6 +65,7 @@ private:
     void parseJSON();
     void parseImage();
     void complete();
+    void finish();
 
 private:
     std::string body;
@@ -69,9 +75,9 @@ private:
     std::unordered_map<std::string, SpritePosition> pos;
     const SpritePosition empty;
 
-    std::promise<void> promise;
-    std::future<void> future;
-
+    bool finished = false;
+    std::vector<std::function<void()>> callbacks;
+    std::mutex mtx;
 };
 
 }
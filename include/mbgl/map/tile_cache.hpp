@@ -0,0 +1,56 @@
+#ifndef MBGL_MAP_TILE_CACHE
+#define MBGL_MAP_TILE_CACHE
+
+#include <mbgl/map/tile.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/ptr.hpp>
+
+#include <list>
+#include <map>
+
+namespace mbgl {
+
+class TileData;
+
+// Keeps fully parsed tiles that dropped out of the viewport around so that we don't have to
+// request and parse them again when they come back into view. The least recently used tiles
+// are evicted first once the total size of the cached tiles exceeds the byte budget.
+class TileCache : private util::noncopyable {
+public:
+    TileCache(size_t maxBytes = 0);
+
+    void setMaxBytes(size_t maxBytes);
+    inline size_t getMaxBytes() const { return maxBytes; }
+    inline size_t getBytes() const { return bytes; }
+
+    // Takes ownership of the tile data. Tiles that are larger than the whole budget are not
+    // cached at all.
+    void add(const Tile::ID &id, const util::ptr<TileData> &data);
+
+    // Removes the tile data from the cache and returns it, or returns an empty pointer if the
+    // tile is not cached.
+    util::ptr<TileData> get(const Tile::ID &id);
+
+    bool has(const Tile::ID &id) const;
+    void clear();
+
+private:
+    void evict();
+
+    struct Entry {
+        util::ptr<TileData> data;
+        size_t bytes;
+        std::list<Tile::ID>::iterator position;
+    };
+
+    size_t maxBytes;
+    size_t bytes = 0;
+
+    // Tile IDs, ordered from least to most recently used.
+    std::list<Tile::ID> order;
+    std::map<Tile::ID, Entry> entries;
+};
+
+}
+
+#endif
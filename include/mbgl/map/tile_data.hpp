@@ -7,6 +7,7 @@
 
 #include <mbgl/util/noncopyable.hpp>
 #include <mbgl/util/ptr.hpp>
+#include <mbgl/util/blob.hpp>
 
 #include <atomic>
 #include <exception>
@@ -22,6 +23,10 @@ class SourceInfo;
 class StyleLayer;
 class Request;
 
+namespace util {
+class WorkRequest;
+}
+
 class TileData : public std::enable_shared_from_this<TileData>,
              private util::noncopyable {
 public:
@@ -47,6 +52,9 @@ public:
     void request(FileSource&);
     void cancel();
     void reparse();
+
+    // Tiles with lower priority values are downloaded and parsed first.
+    void setPriority(double priority);
     const std::string toString() const;
 
     inline bool ready() const {
@@ -58,11 +66,25 @@ public:
     virtual void render(Painter &painter, util::ptr<StyleLayer> layer_desc, const mat4 &matrix) = 0;
     virtual bool hasData(StyleLayer const& layer_desc) const = 0;
 
+    // Returns the approximate number of bytes this tile occupies in memory.
+    virtual size_t bytes() const;
+
+protected:
+    // Called in the map thread once the tile data has arrived. Schedules parsing by default.
+    virtual void loaded(FileSource &fileSource);
+
+    // Called in the map thread after a parse job has run.
+    virtual void afterParse() {}
+
 
 public:
     const Tile::ID id;
     std::atomic<State> state;
 
+    // Set in the map thread when revalidating a stale tile returned a different body. The Source
+    // replaces outdated tiles with newly loaded ones.
+    bool outdated = false;
+
 protected:
     Map &map;
 
@@ -71,7 +93,12 @@ public:
 
 protected:
     std::unique_ptr<Request> req;
-    std::string data;
+    std::string url;
+    util::Blob data;
+
+    // The most recently scheduled parse job, if any.
+    util::ptr<util::WorkRequest> work;
+    double priority = 0;
 
     // Contains the tile ID string for painting debug information.
     DebugFontBuffer debugFontBuffer;
@@ -6,9 +6,12 @@
 #include <mbgl/text/glyph.hpp>
 #include <mbgl/util/ptr.hpp>
 #include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/blob.hpp>
 #include <cstdint>
 #include <iosfwd>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace mbgl {
 
@@ -32,7 +35,7 @@ class Collision;
 class TileParser : private util::noncopyable
 {
 public:
-    TileParser(const std::string &data, VectorTileData &tile,
+    TileParser(const util::Blob &data, VectorTileData &tile,
                const util::ptr<const Style> &style,
                GlyphAtlas & glyphAtlas,
                const util::ptr<GlyphStore> &glyphStore,
@@ -41,11 +44,14 @@ public:
     ~TileParser();
 
 public:
-    void parse();
+    // Returns false when parsing stopped at a symbol bucket whose glyphs or sprite are still
+    // loading. The tile is reparsed once they've loaded; calling parse() again resumes with the
+    // buckets that haven't been created yet.
+    bool parse();
 
 private:
     bool obsolete() const;
-    void parseStyleLayers(util::ptr<StyleLayerGroup> group);
+    void parseStyleLayers(util::ptr<StyleLayerGroup> group, std::vector<util::ptr<StyleBucket>> &bucket_descs);
     std::unique_ptr<Bucket> createBucket(util::ptr<StyleBucket> bucket_desc);
 
     std::unique_ptr<Bucket> createFillBucket(const VectorTileLayer& layer, const FilterExpression &filter, const StyleBucketFill &fill);
@@ -56,6 +62,8 @@ private:
     template <class Bucket> void addBucketGeometries(Bucket& bucket, const VectorTileLayer& layer, const FilterExpression &filter);
 
 private:
+    // Holds the decoded tile and other short-lived data of this parser.
+    util::Arena arena;
     const VectorTile vector_data;
     VectorTileData& tile;
 
@@ -68,6 +76,13 @@ private:
     util::ptr<Texturepool> texturePool;
 
     std::unique_ptr<Collision> collision;
+
+    // Fill and line buckets are built in parallel and then moved into the tile's buffers one
+    // at a time.
+    std::mutex bufferMutex;
+
+    // Whether a symbol bucket is waiting for glyphs or the sprite.
+    bool pending = false;
 };
 
 }
@@ -6,6 +6,8 @@
 #include <mbgl/text/glyph.hpp>
 #include <mbgl/util/pbf.hpp>
 #include <mbgl/util/optional.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/arena.hpp>
 
 #include <cstdint>
 #include <iosfwd>
@@ -27,53 +29,91 @@ enum class FeatureType {
 
 std::ostream& operator<<(std::ostream&, const FeatureType& type);
 
+typedef std::map<std::string, Value, std::less<std::string>,
+                 util::ArenaAllocator<std::pair<const std::string, Value>>> VectorTileProperties;
+
+// The properties are allocated from the arena of the layer.
 class VectorTileFeature {
 public:
     VectorTileFeature(pbf feature, const VectorTileLayer& layer);
+    VectorTileFeature(const VectorTileLayer& layer, uint32_t index);
 
     uint64_t id = 0;
     FeatureType type = FeatureType::Unknown;
-    std::map<std::string, Value> properties;
+    VectorTileProperties properties;
     pbf geometry;
 };
 
 std::ostream& operator<<(std::ostream&, const VectorTileFeature& feature);
 
 
-class VectorTileTagExtractor {
+/*
+ * A filter expression compiled against the key/value dictionary of a layer.
+ * Keys are resolved to key indices once, and the outcome of each comparison is
+ * memoized per value index, so evaluating a feature only compares the integer
+ * tag pairs of the layer's feature table and never copies a Value.
+ *
+ * The memoized results are filled in lazily; an instance must not be shared
+ * between threads.
+ */
+class CompiledFilterExpression : private util::noncopyable {
 public:
-    VectorTileTagExtractor(const VectorTileLayer &layer);
+    CompiledFilterExpression(const FilterExpression &expression, const VectorTileLayer &layer);
 
-    void setTags(const pbf &pbf);
-    mapbox::util::optional<Value> getValue(const std::string &key) const;
-    void setType(FeatureType type);
-    FeatureType getType() const;
+    bool evaluate(uint32_t feature) const;
 
 private:
-    const VectorTileLayer &layer_;
-    pbf tags_;
-    FeatureType type_ = FeatureType::Unknown;
+    struct Node {
+        enum class Type : uint8_t { Constant, GeometryType, Key, Any, All, None };
+
+        Type type;
+
+        // The result for Constant nodes, and for Key nodes when the feature doesn't have the key.
+        bool missing = false;
+
+        // The key index for Key nodes.
+        uint32_t key = 0;
+
+        // The original comparison for Key and GeometryType nodes.
+        const FilterExpression *expression = nullptr;
+
+        // Results for Key nodes indexed by value index, and for GeometryType nodes indexed by
+        // the feature types of the spec. -1 means that the value has not been compared yet.
+        mutable std::vector<int8_t> results;
+
+        // Child node indices for Any, All and None nodes.
+        std::vector<uint32_t> children;
+    };
+
+    struct Compiler;
+
+    uint32_t compile(const FilterExpression &expression);
+    bool evaluate(const Node &node, uint32_t feature) const;
+
+    const VectorTileLayer &layer;
+    std::vector<Node> nodes;
+    uint32_t root;
 };
 
 /*
  * Allows iterating over the features of a VectorTileLayer using a
  * BucketDescription as filter. Only features matching the descriptions will
- * be returned (as pbf).
+ * be returned (as indices into the layer's feature table).
  */
 class FilteredVectorTileLayer {
 public:
     class iterator {
     public:
-        iterator(const FilteredVectorTileLayer& filter, const pbf& data);
+        iterator(const FilteredVectorTileLayer& filter, uint32_t index);
         void operator++();
         bool operator!=(const iterator& other) const;
-        const pbf& operator*() const;
+        uint32_t operator*() const;
 
     private:
+        void advance();
+
         const FilteredVectorTileLayer& parent;
-        bool valid = false;
-        pbf feature;
-        pbf data;
+        uint32_t index;
     };
 
 public:
@@ -84,31 +124,77 @@ public:
 
 private:
     const VectorTileLayer& layer;
-    const FilterExpression& filterExpression;
+    const CompiledFilterExpression filterExpression;
 };
 
 std::ostream& operator<<(std::ostream&, const PositionedGlyph& placement);
 
+/*
+ * Columnar table of all features in a layer. The feature PBFs are decoded
+ * exactly once when the layer is read; all buckets that use this layer iterate
+ * over the table instead of scanning the raw PBF again.
+ */
+class VectorTileFeatureTable {
+public:
+    VectorTileFeatureTable(util::Arena &arena);
+
+    inline uint32_t size() const {
+        return uint32_t(types.size());
+    }
+
+    // Returns the key/value index pairs of a feature.
+    inline const uint32_t *tagsBegin(uint32_t index) const {
+        return tags.data() + tag_offsets[index];
+    }
+    inline const uint32_t *tagsEnd(uint32_t index) const {
+        return tags.data() + tag_offsets[index + 1];
+    }
+
+    util::ArenaVector<FeatureType> types;
+
+    // The tags of feature i are stored in tags[tag_offsets[i]] to
+    // tags[tag_offsets[i + 1]] as alternating key and value indices.
+    util::ArenaVector<uint32_t> tag_offsets;
+    util::ArenaVector<uint32_t> tags;
+
+    // The geometry commands of feature i are stored in the layer data from
+    // byte geometry_offsets[2 * i] to geometry_offsets[2 * i + 1].
+    util::ArenaVector<uint32_t> geometry_offsets;
+};
+
+/*
+ * All containers of a layer are allocated from the arena that is passed to the
+ * constructor. The layer must not outlive it.
+ */
 class VectorTileLayer {
 public:
-    VectorTileLayer(pbf data);
+    VectorTileLayer(pbf data, util::Arena &arena);
+
+    // Returns the encoded geometry commands of a feature.
+    pbf geometry(uint32_t index) const;
 
     const pbf data;
     std::string name;
     uint32_t extent = 4096;
-    std::vector<std::string> keys;
-    std::unordered_map<std::string, uint32_t> key_index;
-    std::vector<Value> values;
+    util::ArenaVector<std::string> keys;
+    std::unordered_map<std::string, uint32_t, std::hash<std::string>, std::equal_to<std::string>,
+                       util::ArenaAllocator<std::pair<const std::string, uint32_t>>> key_index;
+    util::ArenaVector<Value> values;
+    VectorTileFeatureTable features;
     std::map<std::string, std::map<Value, Shaping>> shaping;
+
+private:
+    void addFeature(pbf feature);
 };
 
+// Decodes a tile with all of its layers into the arena, which is typically owned by the
+// TileParser and released in one go once parsing has finished.
 class VectorTile {
 public:
-    VectorTile();
-    VectorTile(pbf data);
-    VectorTile& operator=(VectorTile&& other);
+    VectorTile(pbf data, util::Arena &arena);
 
-    std::map<std::string, const VectorTileLayer> layers;
+    std::map<std::string, const VectorTileLayer, std::less<std::string>,
+             util::ArenaAllocator<std::pair<const std::string, const VectorTileLayer>>> layers;
 };
 
 
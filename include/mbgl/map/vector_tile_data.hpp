@@ -11,6 +11,7 @@
 
 #include <iosfwd>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 namespace mbgl {
@@ -21,6 +22,7 @@ class Painter;
 class SourceInfo;
 class StyleLayer;
 class TileParser;
+class SQLiteStore;
 
 class VectorTileData : public TileData {
     friend class TileParser;
@@ -31,6 +33,18 @@ public:
     virtual void parse();
     virtual void render(Painter &painter, util::ptr<StyleLayer> layer_desc, const mat4 &matrix);
     virtual bool hasData(StyleLayer const& layer_desc) const;
+    virtual size_t bytes() const;
+
+protected:
+    // Looks up previously built buckets in the persistent cache before parsing.
+    virtual void loaded(FileSource &fileSource);
+    virtual void afterParse();
+
+    // Computes the cache key from the tile data and the style properties that fill and line
+    // buckets depend on.
+    std::string bucketCacheKey() const;
+    std::string serializeBuckets() const;
+    bool restoreBuckets(const std::string &serialized);
 
 protected:
     // Holds the actual geometries in this tile.
@@ -46,6 +60,20 @@ protected:
     // Holds the buckets of this tile.
     // They contain the location offsets in the buffers stored above
     std::unordered_map<std::string, std::unique_ptr<Bucket>> buckets;
+
+private:
+    // Kept while parsing waits for glyphs or the sprite.
+    std::unique_ptr<TileParser> parser;
+    std::mutex mtx;
+
+    // Persistent bucket cache. Symbol buckets aren't cached because their vertices refer to
+    // positions in the glyph and sprite atlases, which differ between sessions.
+    util::ptr<SQLiteStore> store;
+    std::string bucketKey;
+    std::string cachedBuckets;
+    std::string serializedBuckets;
+    bool restoredFromCache = false;
+
 public:
     const float depth;
 };
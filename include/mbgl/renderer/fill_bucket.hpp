@@ -4,6 +4,7 @@
 #include <mbgl/renderer/bucket.hpp>
 #include <mbgl/geometry/elements_buffer.hpp>
 #include <mbgl/geometry/fill_buffer.hpp>
+#include <mbgl/geometry/earcut.hpp>
 #include <mbgl/style/style_bucket.hpp>
 
 #include <clipper/clipper.hpp>
@@ -42,6 +43,21 @@ public:
                TriangleElementsBuffer& triangleElementsBuffer,
                LineElementsBuffer& lineElementsBuffer,
                const StyleBucketFill& properties);
+
+    // Restores a bucket that was written with serialize(). The buffers must already contain
+    // the serialized vertices and elements.
+    FillBucket(FillVertexBuffer& vertexBuffer,
+               TriangleElementsBuffer& triangleElementsBuffer,
+               LineElementsBuffer& lineElementsBuffer,
+               const StyleBucketFill& properties,
+               util::BinaryReader& reader);
+
+    // Takes over a bucket that was built into other buffers by appending its vertices and
+    // elements to these buffers.
+    FillBucket(FillVertexBuffer& vertexBuffer,
+               TriangleElementsBuffer& triangleElementsBuffer,
+               LineElementsBuffer& lineElementsBuffer,
+               FillBucket&& other);
     ~FillBucket();
 
     virtual void render(Painter& painter, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix);
@@ -50,6 +66,8 @@ public:
     void addGeometry(pbf& data);
     void tessellate();
 
+    void serialize(util::BinaryWriter& writer) const;
+
     void drawElements(PlainShader& shader);
     void drawElements(PatternShader& shader);
     void drawVertices(OutlineShader& shader);
@@ -57,10 +75,16 @@ public:
 public:
     const StyleBucketFill &properties;
 
+private:
+    // Adds the ring in line if it is a simple polygon. Returns false if it has to go through
+    // the union and libtess2 instead.
+    bool addSimplePolygon();
+
 private:
     TESSalloc *allocator;
     TESStesselator *tesselator;
     ClipperLib::Clipper clipper;
+    Earcut earcut;
 
     FillVertexBuffer& vertexBuffer;
     TriangleElementsBuffer& triangleElementsBuffer;
@@ -29,6 +29,21 @@ public:
                PointElementsBuffer& pointElementsBuffer,
                const StyleBucketLine& properties);
 
+    // Restores a bucket that was written with serialize(). The buffers must already contain
+    // the serialized vertices and elements.
+    LineBucket(LineVertexBuffer& vertexBuffer,
+               TriangleElementsBuffer& triangleElementsBuffer,
+               PointElementsBuffer& pointElementsBuffer,
+               const StyleBucketLine& properties,
+               util::BinaryReader& reader);
+
+    // Takes over a bucket that was built into other buffers by appending its vertices and
+    // elements to these buffers.
+    LineBucket(LineVertexBuffer& vertexBuffer,
+               TriangleElementsBuffer& triangleElementsBuffer,
+               PointElementsBuffer& pointElementsBuffer,
+               LineBucket&& other);
+
     virtual void render(Painter& painter, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix);
     virtual bool hasData() const;
 
@@ -37,6 +52,8 @@ public:
 
     bool hasPoints() const;
 
+    void serialize(util::BinaryWriter& writer) const;
+
     void drawLines(LineShader& shader);
     void drawLinePatterns(LinepatternShader& shader);
     void drawPoints(LinejoinShader& shader);
@@ -55,6 +72,9 @@ private:
 
     std::vector<triangle_group_type> triangleGroups;
     std::vector<point_group_type> pointGroups;
+
+    // Reused for every decoded line so that its capacity carries over between features.
+    std::vector<Coordinate> decodedLine;
 };
 
 }
@@ -13,7 +13,9 @@
 
 #include <memory>
 #include <map>
+#include <set>
 #include <vector>
+#include <functional>
 
 namespace mbgl {
 
@@ -61,9 +63,12 @@ public:
     virtual bool hasTextData() const;
     virtual bool hasIconData() const;
 
-    void addFeatures(const VectorTileLayer &layer, const FilterExpression &filter,
+    // Returns false without adding any features when glyphs or the sprite are still loading.
+    // In that case, the callback is invoked in the map thread once they finished loading.
+    bool addFeatures(const VectorTileLayer &layer, const FilterExpression &filter,
                      const Tile::ID &id, SpriteAtlas &spriteAtlas, Sprite &sprite,
-                     GlyphAtlas &glyphAtlas, GlyphStore &glyphStore);
+                     GlyphAtlas &glyphAtlas, GlyphStore &glyphStore,
+                     const std::function<void()> &callback);
 
     void addGlyphs(const PlacedGlyphs &glyphs, float placementZoom, PlacementRange placementRange,
                    float zoom);
@@ -74,7 +79,7 @@ public:
 
 private:
 
-    std::vector<SymbolFeature> processFeatures(const VectorTileLayer &layer, const FilterExpression &filter, GlyphStore &glyphStore, const Sprite &sprite);
+    std::vector<SymbolFeature> processFeatures(const VectorTileLayer &layer, const FilterExpression &filter, std::set<GlyphRange> &ranges);
 
 
     void addFeature(const pbf &geom_pbf, const Shaping &shaping, const GlyphPositions &face, const Rect<uint16_t> &image);
@@ -108,6 +113,9 @@ private:
         std::vector<IconElementGroup> groups;
     } icon;
 
+    // Reused for every decoded line so that its capacity carries over between features.
+    std::vector<Coordinate> decodedLine;
+
 };
 }
 
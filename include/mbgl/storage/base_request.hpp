@@ -32,10 +32,20 @@ public:
     Callback *add(Callback &&callback, const util::ptr<BaseRequest> &request);
     void remove(Callback *callback);
 
+    // Registers a callback for preliminary responses, e.g. an expired cache entry that is being
+    // revalidated. It is not called with the final response; use add() for that. Unlike add(),
+    // this doesn't deliver an existing preliminary response; the caller must do that once it
+    // has stored the returned callback, so that the callback can remove itself.
+    Callback *addPreliminary(CompletedCallback &&callback, const util::ptr<BaseRequest> &request);
+
     // Must be called by subclasses when a valid Response object is available. It will notify
     // all listeners.
     void notify();
 
+    // May be called by subclasses before notify() to hand out a preliminary response. Unlike
+    // notify(), this keeps all listeners registered.
+    void notifyPreliminary(std::unique_ptr<Response> &&response);
+
     // This function is called when the request ought to be stopped. Any subclass must make sure this
     // is also called in its destructor. Calling this function repeatedly must be safe.
     // This function must call notify().
@@ -45,16 +55,26 @@ public:
     // reaction to a network status change.
     virtual void retryImmediately();
 
+    // This function is called when the order in which the request should be started relative to
+    // other requests changed. Lower values are started first.
+    virtual void setPriority(double priority);
+
 public:
     const unsigned long thread_id;
     const std::string path;
     std::unique_ptr<Response> response;
+    std::unique_ptr<Response> preliminary;
+
+    // Called with the final response before any of the callbacks. Unlike the callbacks, it
+    // doesn't keep the request alive, e.g. for recording responses that nobody waits for.
+    CompletedCallback observer;
 
 protected:
     // This object may hold a shared_ptr to itself. It does this to prevent destruction of this object
     // while a request is in progress.
     util::ptr<BaseRequest> self;
     std::forward_list<std::unique_ptr<Callback>> callbacks;
+    std::forward_list<std::unique_ptr<Callback>> preliminaryCallbacks;
 };
 
 }
@@ -15,6 +15,7 @@ struct FileRequestBaton {
     static void file_opened(uv_fs_t *req);
     static void file_stated(uv_fs_t *req);
     static void file_read(uv_fs_t *req);
+    static bool map_file(uv_fs_t *req, size_t size);
     static void file_closed(uv_fs_t *req);
     static void notify_error(uv_fs_t *req);
     static void cleanup(uv_fs_t *req);
@@ -16,6 +16,9 @@ namespace mbgl {
 
 class BaseRequest;
 class SQLiteStore;
+class MBTilesStore;
+class ResponseCache;
+class ResourceArchive;
 
 class FileSource : public util::noncopyable {
 private:
@@ -33,6 +36,24 @@ public:
 
     void retryAllPending();
 
+    // Returns the persistent cache, or nullptr when running without a cache database.
+    inline util::ptr<SQLiteStore> getStore() const { return store; }
+
+    // Limits the size of the persistent cache; see SQLiteStore::setMaximumSize().
+    void setMaximumCacheSize(uint64_t bytes);
+
+    // Limits the size of the in-memory cache of recent responses. Zero disables it.
+    void setMaximumMemoryCacheSize(size_t bytes);
+
+    // Records the final responses to all requests into the archive, or, in replay mode, serves
+    // all requests from the archive instead of the network, the caches and local files.
+    // Requests that are already in progress aren't affected. Pass nullptr to stop.
+    void setArchive(util::ptr<ResourceArchive> archive);
+
+private:
+    util::ptr<BaseRequest> requestMBTiles(const std::string &url);
+    void record(const std::string &url, const util::ptr<BaseRequest> &req);
+
 private:
     const unsigned long thread_id;
 
@@ -41,6 +62,15 @@ private:
 
     std::unordered_map<std::string, std::weak_ptr<BaseRequest>> pending;
     util::ptr<SQLiteStore> store;
+
+    // Fresh HTTP responses, checked before the persistent cache.
+    util::ptr<ResponseCache> memory;
+
+    util::ptr<ResourceArchive> archive;
+
+    // Opened MBTiles files by path. They are kept open for the lifetime of the FileSource.
+    std::unordered_map<std::string, util::ptr<MBTilesStore>> mbtiles;
+
     uv_loop_t *loop = nullptr;
     uv_messenger_t *queue = nullptr;
 };
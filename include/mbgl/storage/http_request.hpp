@@ -18,14 +18,17 @@ struct CacheRequestBaton;
 struct HTTPRequestBaton;
 struct CacheEntry;
 class SQLiteStore;
+class ResponseCache;
 
 class HTTPRequest : public BaseRequest {
 public:
-    HTTPRequest(ResourceType type, const std::string &path, uv_loop_t *loop, util::ptr<SQLiteStore> store);
+    HTTPRequest(ResourceType type, const std::string &path, uv_loop_t *loop, util::ptr<SQLiteStore> store,
+                util::ptr<ResponseCache> memory = nullptr);
     ~HTTPRequest();
 
     void cancel();
     void retryImmediately();
+    void setPriority(double priority);
 
 private:
     void startCacheRequest();
@@ -46,8 +49,10 @@ private:
     util::ptr<HTTPRequestBaton> http_baton;
     uv_timer_t *backoff_timer = nullptr;
     util::ptr<SQLiteStore> store;
+    util::ptr<ResponseCache> memory;
     const ResourceType type;
     uint8_t attempts = 0;
+    double priority = 0;
 
     friend struct HTTPRequestBaton;
 };
@@ -4,6 +4,7 @@
 #include <mbgl/storage/response.hpp>
 #include <mbgl/util/ptr.hpp>
 
+#include <atomic>
 #include <string>
 
 typedef struct uv_async_s uv_async_t;
@@ -56,6 +57,15 @@ struct HTTPRequestBaton {
     HTTPResponseType type = HTTPResponseType::Unknown;
     std::unique_ptr<Response> response;
 
+    // Requests with lower values are started first. Set in the main thread, read by the
+    // platform implementation.
+    std::atomic<double> priority { 0 };
+
+    // Maximum number of requests in flight, in total and per host. Further requests are queued
+    // until a request completes or is canceled. Not all platforms support both limits.
+    static std::atomic<unsigned int> maximumRequests;
+    static std::atomic<unsigned int> maximumRequestsPerHost;
+
     // Implementation specific use.
     void *ptr = nullptr;
 
@@ -0,0 +1,28 @@
+#ifndef MBGL_STORAGE_MBTILES_REQUEST
+#define MBGL_STORAGE_MBTILES_REQUEST
+
+#include <mbgl/storage/base_request.hpp>
+
+#include <string>
+
+namespace mbgl {
+
+struct MBTilesRequestBaton;
+class MBTilesStore;
+
+// Loads a tile or the TileJSON of an mbtiles:// URL directly from the file.
+class MBTilesRequest : public BaseRequest {
+public:
+    MBTilesRequest(const std::string &path, const std::string &resource, util::ptr<MBTilesStore> store);
+    ~MBTilesRequest();
+
+    void cancel();
+
+private:
+    MBTilesRequestBaton *baton = nullptr;
+    util::ptr<MBTilesStore> store;
+};
+
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef MBGL_STORAGE_MBTILES_STORE
+#define MBGL_STORAGE_MBTILES_STORE
+
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/ptr.hpp>
+
+#include <memory>
+#include <string>
+
+typedef struct uv_loop_s uv_loop_t;
+typedef struct uv_worker_s uv_worker_t;
+
+namespace mbgl {
+
+// Serves the tiles and the TileJSON of an MBTiles file. Lookups run on several threads with
+// read-only connections, so that they don't wait for each other.
+class MBTilesStore : private util::noncopyable {
+public:
+    MBTilesStore(uv_loop_t *loop, const std::string &path);
+    ~MBTilesStore();
+
+    typedef void (*GetCallback)(std::unique_ptr<Response> &&response, void *ptr);
+
+    // The resource is either empty for the TileJSON, or /z/x/y for a tile, optionally followed
+    // by a file extension. Always calls back with a response; tiles that don't exist are
+    // reported with code 404.
+    void get(const std::string &resource, GetCallback cb, void *ptr);
+
+    class ConnectionPool;
+
+private:
+    const unsigned long thread_id;
+    const std::string path;
+    util::ptr<ConnectionPool> readers;
+    uv_worker_t *worker = nullptr;
+};
+
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef MBGL_STORAGE_REPLAY_REQUEST
+#define MBGL_STORAGE_REPLAY_REQUEST
+
+#include <mbgl/storage/base_request.hpp>
+
+#include <string>
+
+typedef struct uv_loop_s uv_loop_t;
+typedef struct uv_timer_s uv_timer_t;
+
+namespace mbgl {
+
+class ResourceArchive;
+
+// Delivers the response recorded in an archive after the latency of the archive's profile.
+class ReplayRequest : public BaseRequest {
+public:
+    ReplayRequest(const std::string &path, uv_loop_t *loop, const ResourceArchive &archive);
+    ~ReplayRequest();
+
+    void cancel();
+
+private:
+    std::unique_ptr<Response> pending;
+    uv_timer_t *timer = nullptr;
+};
+
+}
+
+#endif
@@ -26,8 +26,16 @@ public:
 
     void onload(CompletedCallback cb);
     void oncancel(AbortedCallback cb);
+
+    // Called with stale responses that are shown while they are being revalidated. The final
+    // response is still delivered to the onload callbacks.
+    void onpreliminary(CompletedCallback cb);
     void cancel();
 
+    // Requests with lower values are started first when there are more requests than the
+    // network may run at once. Requests shared by several handles use the value set last.
+    void setPriority(double priority);
+
 private:
     const unsigned long thread_id;
     util::ptr<BaseRequest> base;
@@ -0,0 +1,85 @@
+#ifndef MBGL_STORAGE_RESOURCE_ARCHIVE
+#define MBGL_STORAGE_RESOURCE_ARCHIVE
+
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/time.hpp>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace mbgl {
+
+// An SQLite file with the responses to all requests of a session, and how long each of them
+// took. A FileSource records into it, or replays from it instead of going to the network, the
+// caches and local files, so that loading, parsing and rendering can be benchmarked without
+// a server and with repeatable timings. Must be used in a single thread.
+class ResourceArchive : private util::noncopyable {
+public:
+    enum class Mode : uint8_t {
+        Record,
+        Replay,
+    };
+
+    enum class Latency : uint8_t {
+        // Every response takes as long as it did while recording.
+        Recorded,
+        // Responses are delivered in the next iteration of the loop.
+        None,
+        // Every response takes the configured delay plus the time to transfer its data.
+        Simulated,
+    };
+
+    struct Profile {
+        Latency latency = Latency::Recorded;
+
+        // Used with Latency::Simulated. A bandwidth of zero transfers instantly.
+        uint64_t delay = 0; // milliseconds
+        uint64_t bandwidth = 0; // bytes per second
+    };
+
+    // When recording, responses are added to an existing archive, replacing earlier ones for the
+    // same URL. When replaying, the whole archive is loaded up front so that replaying doesn't
+    // touch the disk.
+    ResourceArchive(const std::string &path, Mode mode);
+    ResourceArchive(const std::string &path, Mode mode, const Profile &profile);
+
+    // Saves responses that were recorded since the last call to save(). Errors are only logged;
+    // call save() to handle them.
+    ~ResourceArchive();
+
+    inline Mode getMode() const { return mode; }
+    inline size_t size() const { return entries.size(); }
+
+    // Records the final response to a request that was started at the given time.
+    void add(const std::string &url, const Response &response, timestamp requested);
+
+    // Throws if the archive can't be written.
+    void save();
+
+    // Returns the recorded response, or a 404 response for URLs that aren't in the archive, and
+    // sets the number of milliseconds it should take to arrive according to the profile.
+    std::unique_ptr<Response> get(const std::string &url, uint64_t &delay) const;
+
+private:
+    struct Entry {
+        Response response;
+        // Milliseconds from the start of the recording to the request, and from the request
+        // to the response.
+        uint64_t started;
+        uint64_t latency;
+        bool saved;
+    };
+
+    const std::string path;
+    const Mode mode;
+    const Profile profile;
+    const timestamp created;
+
+    std::unordered_map<std::string, Entry> entries;
+};
+
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef MBGL_STORAGE_RESPONSE
 #define MBGL_STORAGE_RESPONSE
 
+#include <mbgl/util/blob.hpp>
+
 #include <string>
 #include <ctime>
 
@@ -14,10 +16,16 @@ public:
     int64_t modified = 0;
     int64_t expires = 0;
     std::string etag;
-    std::string data;
+
+    // Shared between all copies of this response.
+    util::Blob data;
 
     std::string message;
 
+    // Set on responses that are delivered from an expired cache entry while it is being
+    // revalidated. A final response follows.
+    bool stale = false;
+
     static int64_t parseCacheControl(const char *value);
 };
 
@@ -0,0 +1,57 @@
+#ifndef MBGL_STORAGE_RESPONSE_CACHE
+#define MBGL_STORAGE_RESPONSE_CACHE
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace mbgl {
+
+class Response;
+
+// Keeps recent responses in memory so that repeated requests for the same resource, e.g. glyph
+// ranges shared by many tiles or a tile that we panned back to, don't have to go through the
+// persistent cache. Only successful responses that haven't expired yet are kept; the least
+// recently used ones are evicted first once the total size exceeds the byte budget.
+// Must be used in a single thread.
+class ResponseCache : private util::noncopyable {
+public:
+    ResponseCache(size_t maxBytes = 0);
+
+    void setMaxBytes(size_t maxBytes);
+    inline size_t getMaxBytes() const { return maxBytes; }
+    inline size_t getBytes() const { return bytes; }
+
+    // Stores a copy of the response, which shares the data with the original. Replaces an
+    // existing entry for the same URL.
+    void add(const std::string &url, const Response &response);
+
+    // Returns a copy of the response, or an empty pointer if it isn't cached or expired.
+    std::unique_ptr<Response> get(const std::string &url);
+
+    void remove(const std::string &url);
+    void clear();
+
+private:
+    void evict();
+
+    struct Entry {
+        std::unique_ptr<Response> response;
+        size_t bytes;
+        std::list<std::string>::iterator position;
+    };
+
+    size_t maxBytes;
+    size_t bytes = 0;
+
+    // URLs, ordered from least to most recently used.
+    std::list<std::string> order;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+}
+
+#endif
@@ -6,16 +6,15 @@
 
 #include <uv.h>
 
+#include <functional>
 #include <string>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 typedef struct uv_worker_s uv_worker_t;
 
-namespace mapbox {
-namespace sqlite {
-class Database;
-}
-}
-
 namespace mbgl {
 
 class SQLiteStore {
@@ -29,7 +28,45 @@ public:
     void put(const std::string &path, ResourceType type, const Response &entry);
     void updateExpiration(const std::string &path, int64_t expires);
 
+    // Stores the parsed buckets of a tile. The key identifies the tile data and style that
+    // produced them; a lookup with a different key doesn't return the entry.
+    typedef void (*GetBucketsCallback)(std::unique_ptr<std::string> &&data, void *ptr);
+
+    void getBuckets(const std::string &path, const std::string &key, GetBucketsCallback cb, void *ptr);
+    void putBuckets(const std::string &path, const std::string &key, std::string &&serialized);
+
+    // Puts, expiration updates and bucket puts are queued and written in a single transaction
+    // once the queue is full or shortly after the first write was queued. This sends the queued
+    // writes to the worker thread right away.
+    void flush();
+
+    // Pins a stored response, so that it is never evicted. Replacing the response keeps the pin.
+    void pin(const std::string &path);
+
+    // Calls back with the paths that aren't pinned, e.g. to resume a bulk download.
+    typedef void (*GetUnpinnedCallback)(std::vector<std::string> &&paths, void *ptr);
+    void getUnpinned(std::vector<std::string> &&paths, GetUnpinnedCallback cb, void *ptr);
+
+    // While at least one bulk writer is active, writes are committed in larger batches.
+    void beginBulkWrites();
+    void endBulkWrites();
+
+    // Limits the size of the stored responses and buckets. Once the limit is exceeded, the least
+    // recently used entries are evicted in the worker thread: tiles with their buckets, then the
+    // largest buckets, then glyphs, images and JSON resources. Pinned responses are never
+    // evicted, but their buckets are. 0 means no limit, which is the default.
+    void setMaximumSize(uint64_t bytes);
+
+    // The database and its prepared statements. Only used by one thread at a time.
+    struct Connection;
+    class ConnectionPool;
+    class AccessLog;
+
 private:
+    typedef std::function<void(Connection &)> Write;
+
+    void enqueue(const std::string &path, Write &&write);
+    void scheduleFlush();
     void createSchema();
     void closeDatabase();
     static void runGet(uv_work_t *req);
@@ -38,8 +75,27 @@ private:
 
 private:
     const unsigned long thread_id;
-    util::ptr<mapbox::sqlite::Database> db;
+    util::ptr<Connection> connection;
     uv_worker_t *worker = nullptr;
+
+    // Lookups run on several threads with read-only connections, so that they neither wait for
+    // each other nor for writes.
+    util::ptr<ConnectionPool> readers;
+    uv_worker_t *reader_worker = nullptr;
+
+    // Lookups that hit record their access time here; it is written with the next batch.
+    util::ptr<AccessLog> accessLog;
+
+    // Only accessed in the loop thread.
+    std::vector<Write> writes;
+    std::unordered_set<std::string> pendingPaths;
+    uv_timer_t *flushTimer = nullptr;
+    unsigned int bulkWriters = 0;
+
+    // Paths with flushed writes that haven't been committed yet, and the number of batches
+    // that contain them. Lookups of these paths go to the writer thread so that they see the
+    // writes. Shared with the write batons, which outlive the store.
+    util::ptr<std::unordered_map<std::string, unsigned int>> committingPaths;
 };
 
 }
@@ -1,6 +1,7 @@
 #ifndef MBGL_STYLE_STYLE_SOURCE
 #define MBGL_STYLE_STYLE_SOURCE
 
+#include <mbgl/map/tile.hpp>
 #include <mbgl/style/types.hpp>
 #include <mbgl/util/ptr.hpp>
 #include <mbgl/util/noncopyable.hpp>
@@ -26,6 +27,9 @@ public:
     std::array<float, 4> bounds = {{-180, -90, 180, 90}};
 
     void parseTileJSONProperties(const rapidjson::Value&);
+
+    // Expands one of the tile URL templates for the given tile.
+    std::string tileURL(const Tile::ID &id, float pixelRatio) const;
 };
 
 
@@ -2,13 +2,21 @@
 #define MBGL_TEXT_GLYPH_STORE
 
 #include <mbgl/text/glyph.hpp>
+#include <mbgl/text/shaping_cache.hpp>
 #include <mbgl/util/pbf.hpp>
 #include <mbgl/util/vec.hpp>
 #include <mbgl/util/ptr.hpp>
+#include <mbgl/util/blob.hpp>
+#include <mbgl/util/noncopyable.hpp>
 
+#include <array>
+#include <atomic>
+#include <bitset>
 #include <cstdint>
+#include <string>
 #include <vector>
-#include <future>
+#include <functional>
+#include <mutex>
 #include <map>
 #include <set>
 #include <unordered_map>
@@ -28,11 +36,42 @@ public:
     GlyphMetrics metrics;
 };
 
-class FontStack {
+// The glyphs of a range of 256 consecutive codepoints of a font stack, as loaded from one glyph
+// PBF. Immutable once it was added to a font stack.
+class GlyphBlock : private util::noncopyable {
 public:
-    void insert(uint32_t id, const SDFGlyph &glyph);
-    const std::map<uint32_t, GlyphMetrics> &getMetrics() const;
-    const std::map<uint32_t, SDFGlyph> &getSDFs() const;
+    static const uint32_t size = 256;
+
+    explicit GlyphBlock(uint32_t first);
+
+    // Glyphs outside of the range of this block are ignored.
+    void add(SDFGlyph &&glyph);
+
+    // Returns nullptr if the block doesn't have a glyph for the codepoint.
+    inline const SDFGlyph *get(uint32_t id) const {
+        return id - first < size && present[id - first] ? &glyphs[id - first] : nullptr;
+    }
+
+    const uint32_t first;
+
+private:
+    std::array<SDFGlyph, size> glyphs;
+    std::bitset<size> present;
+};
+
+// Glyphs are only ever added, in whole blocks, so readers don't need any locks.
+class FontStack : private util::noncopyable {
+public:
+    FontStack();
+    ~FontStack();
+
+    // Publishes the glyphs of a range. If the range was already added, the block is discarded.
+    void insert(std::unique_ptr<GlyphBlock> &&block);
+
+    // Returns nullptr if the glyph isn't loaded. Only the Basic Multilingual Plane is supported.
+    const SDFGlyph *getGlyph(uint32_t id) const;
+
+    // Shapings are cached, so that labels which appear in many tiles are shaped only once.
     const Shaping getShaping(const std::u32string &string, float maxWidth, float lineHeight,
                              float horizontalAlign, float verticalAlign, float justify,
                              float spacing, const vec2<float> &translate) const;
@@ -40,16 +79,22 @@ public:
                   float verticalAlign, float justify) const;
 
 private:
-    std::map<uint32_t, std::string> bitmaps;
-    std::map<uint32_t, GlyphMetrics> metrics;
-    std::map<uint32_t, SDFGlyph> sdfs;
-    mutable std::mutex mtx;
+    // Returns nullptr if the font stack doesn't have the glyph.
+    const GlyphMetrics *findMetrics(uint32_t id) const;
+
+    // Indexed by the first codepoint of the block divided by the block size. Owns the blocks.
+    std::array<std::atomic<const GlyphBlock *>, 65536 / GlyphBlock::size> blocks;
+
+    mutable ShapingCache shapings;
 };
 
 class GlyphPBF {
 public:
     GlyphPBF(const std::string &glyphURL, const std::string &fontStack, GlyphRange glyphRange, FileSource& fileSource);
 
+    // Expands the glyph URL template for a range of a font stack.
+    static std::string getURL(const std::string &glyphURL, const std::string &fontStack, GlyphRange glyphRange);
+
 private:
     GlyphPBF(const GlyphPBF &) = delete;
     GlyphPBF(GlyphPBF &&) = delete;
@@ -59,12 +104,17 @@ private:
 public:
     void parse(FontStack &stack);
 
-    std::shared_future<GlyphPBF &> getFuture();
+    // Returns true when loading this glyph range has finished (successfully or not). Otherwise,
+    // the callback is invoked in the map thread once it has finished.
+    bool isLoaded(const std::function<void()> &callback);
 
 private:
-    std::string data;
-    std::promise<GlyphPBF &> promise;
-    std::shared_future<GlyphPBF &> future;
+    void complete(util::Blob data);
+
+    const GlyphRange range;
+    util::Blob data;
+    bool loaded = false;
+    std::vector<std::function<void()>> callbacks;
     std::mutex mtx;
 };
 
@@ -73,8 +123,11 @@ class GlyphStore {
 public:
     GlyphStore(FileSource& fileSource);
 
-    // Block until all specified GlyphRanges of the specified font stack are loaded.
-    void waitForGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges);
+    // Returns true when all specified GlyphRanges of the specified font stack are loaded and
+    // parsed. Otherwise, it starts loading the missing ranges and returns false; the callback is
+    // invoked in the map thread once one of them has finished loading. Never blocks.
+    bool hasGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges,
+                        const std::function<void()> &callback);
 
     FontStack &getFontStack(const std::string &fontStack);
 
@@ -82,7 +135,7 @@ public:
 
 private:
     // Loads an individual glyph range from the font stack and adds it to rangeSets
-    std::shared_future<GlyphPBF &> loadGlyphRange(const std::string &fontStack, std::map<GlyphRange, std::unique_ptr<GlyphPBF>> &rangeSets, GlyphRange range);
+    GlyphPBF &loadGlyphRange(const std::string &fontStack, std::map<GlyphRange, std::unique_ptr<GlyphPBF>> &rangeSets, GlyphRange range);
 
     FontStack &createFontStack(const std::string &fontStack);
 
@@ -0,0 +1,71 @@
+#ifndef MBGL_TEXT_SHAPING_CACHE
+#define MBGL_TEXT_SHAPING_CACHE
+
+#include <mbgl/text/glyph.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/vec.hpp>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace mbgl {
+
+// All inputs of FontStack::getShaping().
+struct ShapingKey {
+    std::u32string string;
+    float maxWidth;
+    float lineHeight;
+    float horizontalAlign;
+    float verticalAlign;
+    float justify;
+    float spacing;
+    vec2<float> translate;
+
+    bool operator==(const ShapingKey &other) const;
+};
+
+struct ShapingKeyHash {
+    size_t operator()(const ShapingKey &key) const;
+};
+
+// Remembers the shapings of a font stack, so that street and place names that occur in many
+// tiles and at every zoom level are shaped only once. Safe to use from several threads; the
+// entries are spread over shards with a mutex each, so that workers rarely wait for each other.
+class ShapingCache : private util::noncopyable {
+public:
+    // Copies the shaping and returns true if it is cached.
+    bool get(const ShapingKey &key, Shaping &shaping) const;
+
+    // Stores a shaping that was computed after getGeneration() returned the given value. It is
+    // discarded if the cache was cleared in the meantime, since it may be outdated.
+    void add(ShapingKey &&key, const Shaping &shaping, uint64_t generation);
+
+    inline uint64_t getGeneration() const { return generation; }
+
+    // Drops all entries, e.g. after glyphs were added to the font stack.
+    void clear();
+
+private:
+    static const size_t shardCount = 16;
+
+    // Once a shard is full, it starts over; the labels of the current viewport are added again
+    // right away.
+    static const size_t maxShardEntries = 512;
+
+    struct Shard {
+        mutable std::mutex mtx;
+        std::unordered_map<ShapingKey, Shaping, ShapingKeyHash> entries;
+    };
+
+    Shard &shard(const ShapingKey &key) const;
+
+    mutable std::array<Shard, shardCount> shards;
+    std::atomic<uint64_t> generation { 0 };
+};
+
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef MBGL_UTIL_ARENA
+#define MBGL_UTIL_ARENA
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace mbgl {
+namespace util {
+
+// A bump allocator for short-lived objects that all die at the same time. Memory is handed out
+// from large chunks and only released when the arena is destructed; deallocating is a no-op.
+// An arena must only be used by one thread at a time.
+class Arena : private noncopyable {
+public:
+    explicit Arena(size_t chunkSize = 64 * 1024);
+
+    void *allocate(size_t size, size_t alignment);
+
+    // Returns the number of bytes that have been reserved from the system.
+    inline size_t bytes() const { return reserved; }
+
+private:
+    const size_t chunkSize;
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char *pos = nullptr;
+    char *end = nullptr;
+    size_t reserved = 0;
+};
+
+// Standard library allocator that allocates from an Arena. Containers using it must not outlive
+// the arena.
+template <typename T>
+class ArenaAllocator {
+public:
+    // Older standard libraries don't use std::allocator_traits for all containers yet.
+    typedef T value_type;
+    typedef T *pointer;
+    typedef const T *const_pointer;
+    typedef T &reference;
+    typedef const T &const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind {
+        typedef ArenaAllocator<U> other;
+    };
+
+    ArenaAllocator(Arena &arena_) noexcept : arena(&arena_) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena(other.arena) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, size_t) noexcept {}
+
+    template <typename U, typename... Args>
+    void construct(U *p, Args &&... args) {
+        ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    void destroy(U *p) {
+        p->~U();
+    }
+
+    size_t max_size() const noexcept { return size_t(-1) / sizeof(T); }
+
+    template <typename U>
+    inline bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+    template <typename U>
+    inline bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+
+private:
+    template <typename U> friend class ArenaAllocator;
+    Arena *arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef MBGL_UTIL_BINARY
+#define MBGL_UTIL_BINARY
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+
+namespace mbgl {
+namespace util {
+
+// Writes plain values into a byte string in host byte order. The result is only meant to be
+// read back by BinaryReader on the same platform, e.g. for on-disk caches.
+class BinaryWriter : private noncopyable {
+public:
+    template <typename T>
+    void write(T value) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "T must be a plain value");
+        data.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void write(const void *bytes, size_t length) {
+        write<uint64_t>(length);
+        if (length) {
+            data.append(reinterpret_cast<const char *>(bytes), length);
+        }
+    }
+
+    void write(const std::string &string) {
+        write(string.data(), string.size());
+    }
+
+    inline const std::string &str() const { return data; }
+    inline std::string release() { return std::move(data); }
+
+private:
+    std::string data;
+};
+
+// Reads values written by BinaryWriter. Throws std::runtime_error on truncated input.
+class BinaryReader : private noncopyable {
+public:
+    BinaryReader(const std::string &data_) : data(data_) {}
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "T must be a plain value");
+        T value;
+        std::memcpy(&value, advance(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // Returns a pointer to the next blob and stores its length. The pointer is valid as long as
+    // the string that was passed to the constructor.
+    const char *read(size_t &length) {
+        const uint64_t size = read<uint64_t>();
+        if (size > data.size() - pos) {
+            throw std::runtime_error("binary data is truncated");
+        }
+        length = size;
+        return advance(length);
+    }
+
+    std::string readString() {
+        size_t length = 0;
+        const char *bytes = read(length);
+        return { bytes, length };
+    }
+
+    inline bool done() const { return pos == data.size(); }
+
+private:
+    const char *advance(size_t length) {
+        if (length > data.size() - pos) {
+            throw std::runtime_error("binary data is truncated");
+        }
+        const char *bytes = data.data() + pos;
+        pos += length;
+        return bytes;
+    }
+
+private:
+    const std::string &data;
+    size_t pos = 0;
+};
+
+}
+}
+
+#endif
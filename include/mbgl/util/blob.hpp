@@ -0,0 +1,57 @@
+#ifndef MBGL_UTIL_BLOB
+#define MBGL_UTIL_BLOB
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace mbgl {
+namespace util {
+
+// Immutable, reference-counted bytes. Copies share the same memory, so a Blob can be passed
+// along from a network or file request to the tile parser without copying the payload.
+class Blob {
+public:
+    Blob() = default;
+
+    // Takes ownership of the string's bytes.
+    Blob(std::string &&string) {
+        auto owner = std::make_shared<std::string>(std::move(string));
+        length = owner->size();
+        bytes = std::shared_ptr<const char>(owner, owner->data());
+    }
+
+    // Refers to memory owned by some other object, e.g. a memory-mapped file. The deleter of
+    // the shared_ptr releases it once the last Blob is gone.
+    Blob(std::shared_ptr<const char> bytes_, size_t length_)
+        : bytes(std::move(bytes_)), length(length_) {}
+
+    inline const char *data() const { return bytes.get(); }
+    inline size_t size() const { return length; }
+    inline bool empty() const { return length == 0; }
+
+    // Copies the bytes into a string, e.g. for APIs that need a zero-terminated buffer.
+    inline std::string str() const {
+        return length ? std::string(bytes.get(), length) : std::string();
+    }
+
+    // Compares the bytes. Copies of the same Blob are equal without looking at the bytes.
+    inline bool operator==(const Blob &other) const {
+        return length == other.length &&
+               (bytes == other.bytes || length == 0 ||
+                std::memcmp(bytes.get(), other.bytes.get(), length) == 0);
+    }
+
+    inline bool operator!=(const Blob &other) const {
+        return !(*this == other);
+    }
+
+private:
+    std::shared_ptr<const char> bytes;
+    size_t length = 0;
+};
+
+}
+}
+
+#endif
@@ -7,7 +7,14 @@ namespace mbgl {
 namespace util {
 
 std::string compress(const std::string &raw);
+std::string compress(const char *raw, size_t length);
+// Accepts both zlib and gzip compressed data.
 std::string decompress(const std::string &raw);
+std::string decompress(const char *raw, size_t length);
+
+// Returns true if the data is gzip or zlib compressed, or a PNG, JPEG or WebP image. Compressing
+// such data again doesn't save space.
+bool isCompressed(const char *data, size_t length);
 
 }
 }
@@ -61,8 +61,13 @@ public:
 
     template <typename T> void bind(int offset, T value);
     void bind(int offset, const std::string &value, bool retain = true);
+    void bind(int offset, const char *value, size_t length, bool retain = true);
     template <typename T> T get(int offset);
 
+    // Returns the blob of a column without copying. The pointer is valid until the statement
+    // is stepped, reset or destructed.
+    const char *getBlob(int offset, size_t &length);
+
     bool run();
     void reset();
 
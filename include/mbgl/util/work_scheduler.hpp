@@ -0,0 +1,82 @@
+#ifndef MBGL_UTIL_WORK_SCHEDULER
+#define MBGL_UTIL_WORK_SCHEDULER
+
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/ptr.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+typedef struct uv_loop_s uv_loop_t;
+
+namespace mbgl {
+namespace util {
+
+class WorkScheduler;
+
+// Handle to a unit of work that was added to a WorkScheduler.
+class WorkRequest : private util::noncopyable {
+    friend class WorkScheduler;
+
+public:
+    typedef std::function<void()> WorkCallback;
+
+    // Called in the loop thread. The argument is false if the work callback was never run
+    // because the request was canceled before a thread picked it up.
+    typedef std::function<void(bool completed)> AfterWorkCallback;
+
+    WorkRequest(double priority, uint64_t sequence, WorkCallback work, AfterWorkCallback after);
+
+    // Requests with lower values are started first. Can be changed from any thread.
+    void setPriority(double priority);
+    double getPriority() const;
+
+    // Drops the work callback if it hasn't been started yet. Can be called from any thread.
+    void cancel();
+    bool isCanceled() const;
+
+private:
+    std::atomic<double> priority;
+    std::atomic<bool> canceled;
+
+    // Orders requests with the same priority by the time they were added.
+    const uint64_t sequence;
+
+    WorkCallback work;
+    AfterWorkCallback after;
+    bool completed = false;
+};
+
+// Runs work on a pool of threads. Every thread has its own queue and steals work from the other
+// queues once its own queue is empty. Threads always start the queued request with the lowest
+// priority value first, and skip requests that were canceled before they started.
+class WorkScheduler : private util::noncopyable {
+public:
+    // A count of 0 sizes the pool to the hardware concurrency.
+    WorkScheduler(uv_loop_t *loop, unsigned int count = 0, const char *name = nullptr);
+
+    // Cancels all queued requests. The threads are joined asynchronously in the loop thread
+    // once the requests they're currently running have finished.
+    ~WorkScheduler();
+
+    util::ptr<WorkRequest> add(double priority, WorkRequest::WorkCallback work,
+                               WorkRequest::AfterWorkCallback after);
+
+    // Runs the tasks in parallel and returns once all of them have finished. The calling thread
+    // runs tasks as well; threads of the pool only help out while they have no requests to run,
+    // so this can be called from a work callback. Rethrows the first exception a task threw.
+    void parallel(const std::vector<std::function<void()>> &tasks);
+
+    unsigned int getThreadCount() const;
+
+private:
+    class Impl;
+    Impl *impl;
+};
+
+}
+}
+
+#endif
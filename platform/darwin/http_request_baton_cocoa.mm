@@ -23,7 +23,9 @@ void HTTPRequestBaton::start(const util::ptr<HTTPRequestBaton> &ptr) {
     dispatch_once(&request_initialize, ^{
         NSURLSessionConfiguration *sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
         sessionConfig.timeoutIntervalForResource = 30;
-        sessionConfig.HTTPMaximumConnectionsPerHost = 8;
+        // NSURLSession queues requests beyond this limit itself, without a total limit or
+        // priorities.
+        sessionConfig.HTTPMaximumConnectionsPerHost = HTTPRequestBaton::maximumRequestsPerHost;
         sessionConfig.requestCachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
         sessionConfig.URLCache = nil;
 
@@ -88,7 +90,7 @@ void HTTPRequestBaton::start(const util::ptr<HTTPRequestBaton> &ptr) {
             } else {
                 baton->response = std::make_unique<Response>();
                 baton->response->code = code;
-                baton->response->data = {(const char *)[data bytes], [data length]};
+                baton->response->data = std::string((const char *)[data bytes], [data length]);
             }
 
             if (code == 304) {
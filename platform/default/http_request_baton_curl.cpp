@@ -7,6 +7,9 @@
 #include <curl/curl.h>
 
 #include <queue>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -87,12 +90,42 @@ static std::queue<CURL *> handles;
 
 namespace mbgl {
 
+struct Context;
+
+}
+
+// Requests that wait for a free slot before they are added to the multi handle, and the number
+// of requests in the multi handle, in total and per host.
+static std::list<mbgl::Context *> queued;
+static unsigned int active = 0;
+static std::unordered_map<std::string, unsigned int> active_per_host;
+
+namespace mbgl {
+
+// Returns the host and port of a URL, which identify the connections that requests can share.
+std::string url_host(const std::string &url) {
+    size_t begin = url.find("://");
+    begin = begin == std::string::npos ? 0 : begin + 3;
+    const size_t end = url.find_first_of("/?#", begin);
+    return url.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+}
+
 struct Context {
     const util::ptr<HTTPRequestBaton> baton;
     CURL *handle = nullptr;
     curl_slist *headers = nullptr;
 
-    Context(const util::ptr<HTTPRequestBaton> &baton_) : baton(baton_) {
+    const std::string host;
+
+    // Whether the handle was added to the multi handle. Otherwise, this context is queued.
+    bool started = false;
+    std::list<Context *>::iterator position;
+
+    // Collects the response body. It is handed over to the Response without copying once the
+    // request has completed.
+    std::string body;
+
+    Context(const util::ptr<HTTPRequestBaton> &baton_) : baton(baton_), host(url_host(baton->path)) {
         assert(baton);
         baton->ptr = this;
 
@@ -112,11 +145,22 @@ struct Context {
             headers = nullptr;
         }
 
-        CURLMcode error = curl_multi_remove_handle(multi, handle);
-        if (error != CURLM_OK) {
-            baton->response = std::unique_ptr<Response>(new Response());
-            baton->response->code = -1;
-            baton->response->message = curl_multi_strerror(error);
+        if (started) {
+            // Frees the slot of this request; the caller starts the next queued request.
+            CURLMcode error = curl_multi_remove_handle(multi, handle);
+            if (error != CURLM_OK) {
+                baton->response = std::unique_ptr<Response>(new Response());
+                baton->response->code = -1;
+                baton->response->message = curl_multi_strerror(error);
+            }
+
+            active--;
+            auto it = active_per_host.find(host);
+            if (--it->second == 0) {
+                active_per_host.erase(it);
+            }
+        } else {
+            queued.erase(position);
         }
 
         curl_easy_setopt(handle, CURLOPT_PRIVATE, nullptr);
@@ -175,6 +219,44 @@ void curl_share_unlock(CURL *, curl_lock_data, void *) {
     uv_mutex_unlock(&share_mutex);
 }
 
+// Adds the queued requests with the lowest priority values to the multi handle, as long as the
+// limits allow. Priorities may change at any time, so the queue is scanned instead of sorted;
+// it rarely holds more than a few hundred requests.
+void start_queued() {
+    const unsigned int maximum = std::max(1u, HTTPRequestBaton::maximumRequests.load());
+    const unsigned int maximum_per_host = std::max(1u, HTTPRequestBaton::maximumRequestsPerHost.load());
+
+    while (active < maximum && !queued.empty()) {
+        auto next = queued.end();
+        double next_priority = 0;
+        for (auto it = queued.begin(); it != queued.end(); ++it) {
+            auto host = active_per_host.find((*it)->host);
+            if (host != active_per_host.end() && host->second >= maximum_per_host) {
+                continue;
+            }
+            const double priority = (*it)->baton->priority;
+            if (next == queued.end() || priority < next_priority) {
+                next = it;
+                next_priority = priority;
+            }
+        }
+
+        if (next == queued.end()) {
+            // All queued requests are for hosts that reached their limit.
+            break;
+        }
+
+        Context *context = *next;
+        queued.erase(next);
+        context->started = true;
+        active++;
+        active_per_host[context->host]++;
+
+        // Start requesting the information.
+        curl_multi_add_handle(multi, context->handle);
+    }
+}
+
 void check_multi_info() {
     CURLMsg *message = nullptr;
     int pending = 0;
@@ -217,6 +299,7 @@ void check_multi_info() {
 
                 if (code != 304) {
                     baton->response->code = code;
+                    baton->response->data = std::move(context->body);
                 }
 
                 if (code == 304) {
@@ -233,6 +316,7 @@ void check_multi_info() {
             }
 
             delete context;
+            start_queued();
         } break;
 
         default:
@@ -361,9 +445,8 @@ void thread_init(void *) {
 // This function is called when we have new data for a request. We just append it to the string
 // containing the previous data.
 size_t curl_write_cb(void *const contents, const size_t size, const size_t nmemb, void *const userp) {
-    auto &response = *(std::unique_ptr<Response> *)userp;
-    assert(response);
-    response->data.append((char *)contents, size * nmemb);
+    auto &body = *(std::string *)userp;
+    body.append((char *)contents, size * nmemb);
     return size * nmemb;
 }
 
@@ -438,14 +521,15 @@ void start_request(void *const ptr) {
     curl_easy_setopt(context->handle, CURLOPT_FOLLOWLOCATION, 1);
     curl_easy_setopt(context->handle, CURLOPT_URL, context->baton->path.c_str());
     curl_easy_setopt(context->handle, CURLOPT_WRITEFUNCTION, curl_write_cb);
-    curl_easy_setopt(context->handle, CURLOPT_WRITEDATA, &context->baton->response);
+    curl_easy_setopt(context->handle, CURLOPT_WRITEDATA, &context->body);
     curl_easy_setopt(context->handle, CURLOPT_HEADERFUNCTION, curl_header_cb);
     curl_easy_setopt(context->handle, CURLOPT_HEADERDATA, &context->baton->response);
     curl_easy_setopt(context->handle, CURLOPT_ACCEPT_ENCODING, "gzip, deflate");
     curl_easy_setopt(context->handle, CURLOPT_SHARE, share);
 
-    // Start requesting the information.
-    curl_multi_add_handle(multi, context->handle);
+    // Wait for a free slot.
+    context->position = queued.insert(queued.end(), context);
+    start_queued();
 }
 
 // This function must run in the CURL thread.
@@ -460,9 +544,10 @@ void stop_request(void *const ptr) {
 
         assert(baton->ptr);
 
-        // We can still stop the request because it is still in progress.
+        // We can still stop the request because it is still in progress or queued.
         delete (Context *)baton->ptr;
         assert(!baton->ptr);
+        start_queued();
     } else {
         // If the async handle is gone, it means that the actual request has been completed before
         // we got a chance to cancel it. In this case, this is a no-op. It is likely that
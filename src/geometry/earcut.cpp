@@ -0,0 +1,177 @@
+#include <mbgl/geometry/earcut.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace mbgl;
+
+namespace {
+
+typedef Earcut::Point Point;
+
+// Coordinates are limited so that cross products and the area can be computed with 64 bit
+// integers. Tile coordinates are far smaller than this.
+const ClipperLib::cInt maxCoordinate = 1 << 24;
+
+inline int64_t cross(const Point &a, const Point &b, const Point &c) {
+    return int64_t(b.X - a.X) * (c.Y - a.Y) - int64_t(b.Y - a.Y) * (c.X - a.X);
+}
+
+inline int sign(int64_t value) {
+    return (value > 0) - (value < 0);
+}
+
+// Assumes that a, b and c are collinear.
+inline bool onSegment(const Point &a, const Point &b, const Point &c) {
+    return std::min(a.X, c.X) <= b.X && b.X <= std::max(a.X, c.X) &&
+           std::min(a.Y, c.Y) <= b.Y && b.Y <= std::max(a.Y, c.Y);
+}
+
+// Returns true if the segments intersect or touch.
+bool intersects(const Point &p1, const Point &q1, const Point &p2, const Point &q2) {
+    const int o1 = sign(cross(p1, q1, p2));
+    const int o2 = sign(cross(p1, q1, q2));
+    const int o3 = sign(cross(p2, q2, p1));
+    const int o4 = sign(cross(p2, q2, q1));
+
+    if (o1 != o2 && o3 != o4) {
+        return true;
+    }
+
+    return (o1 == 0 && onSegment(p1, p2, q1)) ||
+           (o2 == 0 && onSegment(p1, q2, q1)) ||
+           (o3 == 0 && onSegment(p2, p1, q2)) ||
+           (o4 == 0 && onSegment(p2, q1, q2));
+}
+
+}
+
+const size_t Earcut::maxVertices;
+
+bool Earcut::triangulate(const std::vector<Point> &ring) {
+    points.clear();
+    triangles.clear();
+
+    if (ring.size() > maxVertices + 1) {
+        return false;
+    }
+
+    // Drop repeated points, including the closing point of the ring.
+    for (const Point &point : ring) {
+        if (std::abs(point.X) > maxCoordinate || std::abs(point.Y) > maxCoordinate) {
+            points.clear();
+            return false;
+        }
+        if (points.empty() || !(points.back() == point)) {
+            points.push_back(point);
+        }
+    }
+    while (points.size() > 1 && points.front() == points.back()) {
+        points.pop_back();
+    }
+
+    const uint16_t count = points.size();
+    if (count > maxVertices) {
+        points.clear();
+        return false;
+    }
+
+    if (count < 3) {
+        points.clear();
+        return true;
+    }
+
+    if (!isSimple()) {
+        points.clear();
+        return false;
+    }
+
+    int64_t area = 0;
+    for (uint16_t i = 0, j = count - 1; i < count; j = i++) {
+        area += int64_t(points[j].X) * points[i].Y - int64_t(points[i].X) * points[j].Y;
+    }
+
+    if (area <= 0) {
+        // Negative rings are holes without an outer ring; they are not filled.
+        points.clear();
+        return true;
+    }
+
+    prev.resize(count);
+    next.resize(count);
+    for (uint16_t i = 0; i < count; i++) {
+        prev[i] = i == 0 ? count - 1 : i - 1;
+        next[i] = i == count - 1 ? 0 : i + 1;
+    }
+
+    uint16_t remaining = count;
+    uint16_t ear = 0;
+    uint16_t attempts = 0;
+    while (remaining > 3) {
+        const uint16_t a = prev[ear];
+        const uint16_t c = next[ear];
+        const int64_t turn = cross(points[a], points[ear], points[c]);
+
+        // Collinear vertices are dropped without emitting a triangle.
+        if (turn == 0 || (turn > 0 && isEar(a, ear, c))) {
+            if (turn != 0) {
+                triangles.push_back(a);
+                triangles.push_back(ear);
+                triangles.push_back(c);
+            }
+            next[a] = c;
+            prev[c] = a;
+            remaining--;
+            attempts = 0;
+            // Continue with the previous vertex, which may have just become an ear.
+            ear = a;
+        } else if (++attempts > remaining) {
+            // We went around the ring without finding an ear.
+            points.clear();
+            triangles.clear();
+            return false;
+        } else {
+            ear = c;
+        }
+    }
+
+    if (cross(points[prev[ear]], points[ear], points[next[ear]]) != 0) {
+        triangles.push_back(prev[ear]);
+        triangles.push_back(ear);
+        triangles.push_back(next[ear]);
+    }
+
+    return true;
+}
+
+bool Earcut::isSimple() const {
+    const size_t count = points.size();
+    for (size_t i = 0; i < count; i++) {
+        const Point &p1 = points[i];
+        const Point &q1 = points[(i + 1) % count];
+
+        // Adjacent segments share a vertex, so only check the ones after the next segment and
+        // skip the last one when it wraps around to the first.
+        for (size_t j = i + 2; j < count && (i > 0 || j < count - 1); j++) {
+            if (intersects(p1, q1, points[j], points[(j + 1) % count])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Earcut::isEar(uint16_t a, uint16_t b, uint16_t c) const {
+    const Point &pa = points[a];
+    const Point &pb = points[b];
+    const Point &pc = points[c];
+
+    // No other remaining vertex may lie in or on the triangle.
+    for (uint16_t p = next[c]; p != a; p = next[p]) {
+        const Point &point = points[p];
+        if (cross(pa, pb, point) >= 0 && cross(pb, pc, point) >= 0 && cross(pc, pa, point) >= 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -2,6 +2,7 @@
 #include <mbgl/map/vector_tile.hpp>
 #include <mbgl/platform/gl.hpp>
 #include <mbgl/platform/platform.hpp>
+#include <mbgl/platform/log.hpp>
 
 #include <cassert>
 #include <algorithm>
@@ -9,16 +10,32 @@
 
 using namespace mbgl;
 
-GlyphAtlas::GlyphAtlas(uint16_t width_, uint16_t height_)
+GlyphAtlas::GlyphAtlas(uint16_t width_, uint16_t height_, uint16_t maxHeight_)
     : width(width_),
-      height(height_),
+      maxHeight(std::max(height_, maxHeight_)),
       bin(width_, height_),
-      data(new char[width_ *height_]),
-      dirty(true) {
+      height(height_),
+      data(width_ * height_, 0),
+      dirty(true),
+      dirtyTop(height_) {
 }
 
 GlyphAtlas::~GlyphAtlas() {
-    delete[] data;
+}
+
+bool GlyphAtlas::grow() {
+    if (height >= maxHeight) {
+        return false;
+    }
+
+    // Glyphs keep their position; the new rows are added at the bottom.
+    const uint16_t newHeight = std::min<uint32_t>(height * 2, maxHeight);
+    bin.grow(newHeight);
+    data.resize(width * newHeight, 0);
+    height = newHeight;
+    dirty = true;
+
+    return true;
 }
 
 Rect<uint16_t> GlyphAtlas::addGlyph(uint64_t tile_id, const std::string& face_name,
@@ -34,13 +51,15 @@ Rect<uint16_t> GlyphAtlas::addGlyph_impl(uint64_t tile_id, const std::string& fa
     // Use constant value for now.
     const uint8_t buffer = 3;
 
-    std::map<uint32_t, GlyphValue>& face = index[face_name];
-    std::map<uint32_t, GlyphValue>::iterator it = face.find(glyph.id);
+    Face& face = index[face_name];
+    Face::iterator it = face.find(glyph.id);
 
     // The glyph is already in this texture.
     if (it != face.end()) {
         GlyphValue& value = it->second;
-        value.ids.insert(tile_id);
+        if (tiles[tile_id].emplace(&face, glyph.id).second) {
+            value.refs++;
+        }
         return value.rect;
     }
 
@@ -56,34 +75,40 @@ Rect<uint16_t> GlyphAtlas::addGlyph_impl(uint64_t tile_id, const std::string& fa
     uint16_t pack_width = buffered_width;
     uint16_t pack_height = buffered_height;
 
-    // Increase to next number divisible by 4, but at least 1.
-    // This is so we can scale down the texture coordinates and pack them
-    // into 2 bytes rather than 4 bytes.
+    // Increase to next number divisible by 4, but at least 1, so that there is some space
+    // between the glyphs.
     pack_width += (4 - pack_width % 4);
     pack_height += (4 - pack_height % 4);
 
     Rect<uint16_t> rect = bin.allocate(pack_width, pack_height);
+    while (rect.w == 0 && grow()) {
+        rect = bin.allocate(pack_width, pack_height);
+    }
     if (rect.w == 0) {
-        fprintf(stderr, "glyph bitmap overflow");
+        Log::Warning(Event::OpenGL, "glyph bitmap overflow");
         return rect;
     }
 
     assert(rect.x + rect.w <= width);
     assert(rect.y + rect.h <= height);
 
-    face.emplace(glyph.id, GlyphValue { rect, tile_id });
+    face.emplace(glyph.id, GlyphValue { rect }).first->second.refs = 1;
+    tiles[tile_id].emplace(&face, glyph.id);
 
-    // Copy the bitmap
-    char *target = data;
+    // Copy the bitmap. Glyphs that were removed aren't cleared, so the rest of the allocated
+    // space is cleared here.
+    char *target = data.data();
     const char *source = glyph.bitmap.data();
-    for (uint32_t y = 0; y < buffered_height; y++) {
+    for (uint32_t y = 0; y < rect.h; y++) {
         uint32_t y1 = width * (rect.y + y) + rect.x;
         uint32_t y2 = buffered_width * y;
-        for (uint32_t x = 0; x < buffered_width; x++) {
-            target[y1 + x] = source[y2 + x];
+        for (uint32_t x = 0; x < rect.w; x++) {
+            target[y1 + x] = (x < buffered_width && y < buffered_height) ? source[y2 + x] : 0;
         }
     }
 
+    dirtyTop = std::min(dirtyTop, rect.y);
+    dirtyBottom = std::max<uint16_t>(dirtyBottom, rect.y + rect.h);
     dirty = true;
 
     return rect;
@@ -93,15 +118,13 @@ void GlyphAtlas::addGlyphs(uint64_t tileid, std::u32string const& text, std::str
 {
     std::lock_guard<std::mutex> lock(mtx);
 
-    std::map<uint32_t, SDFGlyph> const& sdfs = fontStack.getSDFs();
     for (uint32_t chr : text)
     {
-        auto sdf_it = sdfs.find(chr);
-        if (sdf_it != sdfs.end())
+        const SDFGlyph *sdf = fontStack.getGlyph(chr);
+        if (sdf)
         {
-            SDFGlyph const& sdf = sdf_it->second;
-            Rect<uint16_t> rect = addGlyph_impl(tileid, stackname, sdf);
-            face.emplace(chr, Glyph{rect, sdf.metrics});
+            Rect<uint16_t> rect = addGlyph_impl(tileid, stackname, *sdf);
+            face.emplace(chr, Glyph{rect, sdf->metrics});
         }
     }
 }
@@ -109,38 +132,26 @@ void GlyphAtlas::addGlyphs(uint64_t tileid, std::u32string const& text, std::str
 void GlyphAtlas::removeGlyphs(uint64_t tile_id) {
     std::lock_guard<std::mutex> lock(mtx);
 
-    for (auto& faces : index) {
-        std::map<uint32_t, GlyphValue>& face = faces.second;
-        for (auto it = face.begin(); it != face.end(); /* we advance in the body */) {
-            GlyphValue& value = it->second;
-            value.ids.erase(tile_id);
-
-            if (!value.ids.size()) {
-                const Rect<uint16_t>& rect = value.rect;
-
-                // Clear out the bitmap.
-                char *target = data;
-                for (uint32_t y = 0; y < rect.h; y++) {
-                    uint32_t y1 = width * (rect.y + y) + rect.x;
-                    for (uint32_t x = 0; x < rect.w; x++) {
-                        target[y1 + x] = 0;
-                    }
-                }
-
-                dirty = true;
-
-                bin.release(rect);
-
-                // Make sure to post-increment the iterator: This will return the
-                // current iterator, but will go to the next position before we
-                // erase the element from the map. That way, the iterator stays
-                // valid.
-                face.erase(it++);
-            } else {
-                ++it;
-            }
+    auto tile = tiles.find(tile_id);
+    if (tile == tiles.end()) {
+        return;
+    }
+
+    for (const std::pair<Face *, uint32_t>& ref : tile->second) {
+        Face& face = *ref.first;
+        auto it = face.find(ref.second);
+        assert(it != face.end());
+
+        GlyphValue& value = it->second;
+        if (!--value.refs) {
+            // The bitmap stays in place until the space is used by another glyph; nothing
+            // refers to it anymore, so there is no need to upload the change.
+            bin.release(value.rect);
+            face.erase(it);
         }
     }
+
+    tiles.erase(tile);
 }
 
 void GlyphAtlas::bind() {
@@ -157,11 +168,43 @@ void GlyphAtlas::bind() {
 
     if (dirty) {
         std::lock_guard<std::mutex> lock(mtx);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, width, height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, data);
+
+        if (textureHeight != height) {
+            // The first upload, or the atlas has grown.
+            glTexImage2D(
+                GL_TEXTURE_2D, // GLenum target
+                0, // GLint level
+                GL_ALPHA, // GLint internalformat
+                width, // GLsizei width
+                height, // GLsizei height
+                0, // GLint border
+                GL_ALPHA, // GLenum format
+                GL_UNSIGNED_BYTE, // GLenum type
+                data.data() // const GLvoid * data
+            );
+            textureHeight = height;
+        } else if (dirtyTop < dirtyBottom) {
+            // OpenGL ES 2 can't upload parts of rows from a larger image, so we upload the
+            // full width of the changed rows.
+            glTexSubImage2D(
+                GL_TEXTURE_2D, // GLenum target
+                0, // GLint level
+                0, // GLint xoffset
+                dirtyTop, // GLint yoffset
+                width, // GLsizei width
+                dirtyBottom - dirtyTop, // GLsizei height
+                GL_ALPHA, // GLenum format
+                GL_UNSIGNED_BYTE, // GLenum type
+                data.data() + width * dirtyTop // const GLvoid *pixels
+            );
+        }
+
+        dirtyTop = height;
+        dirtyBottom = 0;
         dirty = false;
 
 #if defined(DEBUG)
-        // platform::show_debug_image("Glyph Atlas", data, width, height);
+        // platform::show_debug_image("Glyph Atlas", data.data(), width, height);
 #endif
     }
 };
@@ -26,8 +26,8 @@ size_t TextVertexBuffer::add(int16_t x, int16_t y, float ox, float oy, uint16_t
     ubytes[12] = util::max((int16_t)std::round(range[0] * angleFactor), (int16_t)0) % 256;
     ubytes[13] = util::min((int16_t)std::round(range[1] * angleFactor), (int16_t)255) % 256;
 
-    ubytes[14] = tx / 4;
-    ubytes[15] = ty / 4;
+    shorts[8] = tx;
+    shorts[9] = ty;
 
     return idx;
 }
@@ -10,6 +10,7 @@
 #include <mbgl/util/string.hpp>
 #include <mbgl/util/constants.hpp>
 #include <mbgl/util/uv_detail.hpp>
+#include <mbgl/util/work_scheduler.hpp>
 #include <mbgl/util/std.hpp>
 #include <mbgl/util/mapbox.hpp>
 #include <mbgl/style/style.hpp>
@@ -96,7 +97,7 @@ Map::Map(View& view_)
       main_thread(uv_thread_self()),
 #endif
       transform(view_),
-      glyphAtlas(1024, 1024),
+      glyphAtlas(1024, 512),
       spriteAtlas(512, 512),
       texturepool(std::make_shared<Texturepool>()),
       painter(spriteAtlas, glyphAtlas)
@@ -124,9 +125,10 @@ Map::~Map() {
     uv_run(**loop, UV_RUN_DEFAULT);
 }
 
-uv::worker &Map::getWorker() {
+util::WorkScheduler &Map::getWorker() {
     if (!workers) {
-        workers = std::make_unique<uv::worker>(**loop, 4, "Tile Worker");
+        // Sizes the pool to the number of available cores.
+        workers = std::make_unique<util::WorkScheduler>(**loop, 0, "Tile Worker");
     }
     return *workers;
 }
@@ -552,6 +554,17 @@ void Map::stopRotating() {
 }
 
 
+#pragma mark - Tile cache
+
+void Map::setTileCacheSize(size_t bytes) {
+    tileCacheSize = bytes;
+    update();
+}
+
+size_t Map::getTileCacheSize() const {
+    return tileCacheSize;
+}
+
 #pragma mark - Toggles
 
 void Map::setDebug(bool value) {
@@ -664,7 +677,7 @@ void Map::prepare() {
                     base = styleURL.substr(0, pos + 1);
                 }
 
-                setStyleJSON(res.data, base);
+                setStyleJSON(res.data.str(), base);
             } else {
                 Log::Error(Event::Setup, "loading style failed: %ld (%s)", res.code, res.message.c_str());
             }
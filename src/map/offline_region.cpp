@@ -0,0 +1,344 @@
+#include <mbgl/map/offline_region.hpp>
+#include <mbgl/map/tile.hpp>
+#include <mbgl/platform/log.hpp>
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/storage/sqlite_store.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_bucket.hpp>
+#include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/text/glyph_store.hpp>
+#include <mbgl/util/mapbox.hpp>
+#include <mbgl/util/math.hpp>
+#include <mbgl/util/std.hpp>
+#include <mbgl/util/vec.hpp>
+
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <set>
+#include <unordered_map>
+
+namespace mbgl {
+
+namespace {
+
+// Collects the sources and font stacks of all layers.
+void collect(const util::ptr<StyleLayerGroup> &group, std::set<util::ptr<StyleSource>> &sources,
+             std::set<std::string> &fonts) {
+    if (!group) {
+        return;
+    }
+    for (const util::ptr<StyleLayer> &layer : group->layers) {
+        if (!layer) continue;
+        if (layer->bucket) {
+            if (layer->bucket->style_source) {
+                sources.insert(layer->bucket->style_source);
+            }
+            if (layer->bucket->render.is<StyleBucketSymbol>()) {
+                const StyleBucketSymbol &symbol = layer->bucket->render.get<StyleBucketSymbol>();
+                if (!symbol.text.field.empty() && !symbol.text.font.empty()) {
+                    fonts.insert(symbol.text.font);
+                }
+            }
+        } else if (layer->layers) {
+            collect(layer->layers, sources, fonts);
+        }
+    }
+}
+
+}
+
+struct OfflineLookupBaton {
+    std::weak_ptr<OfflineRegion> region;
+    std::unordered_map<std::string, ResourceType> types;
+};
+
+OfflineRegion::OfflineRegion(FileSource &fileSource_, const Options &options_)
+    : fileSource(fileSource_), options(options_), store(fileSource.getStore()) {
+}
+
+OfflineRegion::~OfflineRegion() {
+    cancel();
+}
+
+void OfflineRegion::start(ProgressCallback callback_) {
+    assert(!started);
+    started = true;
+    callback = callback_;
+
+    if (store) {
+        store->beginBulkWrites();
+    } else {
+        Log::Warning(Event::Database, "offline region is downloaded without a cache");
+    }
+
+    seen.insert(options.styleURL);
+    progress.total++;
+    load({ ResourceType::JSON, options.styleURL }, [this](const Response &res) {
+        loadStyle(res);
+    });
+}
+
+void OfflineRegion::cancel() {
+    if (!started || stopped) {
+        return;
+    }
+    stopped = true;
+
+    for (const std::unique_ptr<Request> &request : requests) {
+        request->cancel();
+    }
+    requests.clear();
+    queue.clear();
+
+    if (store) {
+        store->endBulkWrites();
+    }
+}
+
+std::vector<std::pair<int32_t, int32_t>> OfflineRegion::tiles(int8_t z) const {
+    const int32_t dim = 1 << z;
+
+    // Projects to fractional tile coordinates at this zoom level.
+    auto project = [dim](double lon, double lat) {
+        lat = util::clamp(lat, -85.0511, 85.0511);
+        return vec2<double> {
+            (lon + 180) / 360 * dim,
+            (180 - 180 / M_PI * std::log(std::tan(M_PI / 4 + lat * M_PI / 360))) / 360 * dim
+        };
+    };
+
+    box bounds;
+    bounds.tl = project(options.west, options.north);
+    bounds.tr = project(options.east, options.north);
+    bounds.br = project(options.east, options.south);
+    bounds.bl = project(options.west, options.south);
+    bounds.center = project((options.west + options.east) / 2, (options.south + options.north) / 2);
+
+    std::vector<std::pair<int32_t, int32_t>> result;
+    for (const Tile::ID &id : Tile::cover(z, bounds)) {
+        if (id.x >= 0 && id.x < dim && id.y >= 0 && id.y < dim) {
+            result.emplace_back(id.x, id.y);
+        }
+    }
+
+    // The two triangles of the cover overlap along the diagonal.
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void OfflineRegion::load(const Resource &resource, LoadedCallback loaded) {
+    active++;
+
+    std::weak_ptr<OfflineRegion> weak_region = shared_from_this();
+    auto it = requests.insert(requests.end(), fileSource.request(resource.type, resource.url));
+    (*it)->onload([weak_region, it, resource, loaded](const Response &res) {
+        util::ptr<OfflineRegion> region = weak_region.lock();
+        if (!region || region->stopped) {
+            return;
+        }
+
+        // The request may own the response, so it lives until we're done with it.
+        const std::unique_ptr<Request> request = std::move(*it);
+        region->requests.erase(it);
+
+        // Still counted as active while it adds resources, so that the download isn't done yet.
+        if (res.code == 200 && loaded) {
+            loaded(res);
+        }
+        region->active--;
+        region->finished(resource, res);
+    });
+}
+
+void OfflineRegion::loadStyle(const Response &res) {
+    std::set<util::ptr<StyleSource>> sources;
+    std::set<std::string> fonts;
+    std::vector<Resource> resources;
+
+    try {
+        const std::string json = res.data.str();
+        style = std::make_unique<Style>();
+        style->loadJSON((const uint8_t *)json.c_str());
+        collect(style->layers, sources, fonts);
+
+        // The same URLs that Sprite loads.
+        const std::string &spriteURL = style->getSpriteURL();
+        if (!spriteURL.empty()) {
+            const std::string base = spriteURL + (options.pixelRatio > 1 ? "@2x" : "");
+            resources.push_back({ ResourceType::JSON, base + ".json" });
+            resources.push_back({ ResourceType::Image, base + ".png" });
+        }
+
+        if (!style->glyph_url.empty()) {
+            const std::string glyphURL = util::mapbox::normalizeGlyphsURL(style->glyph_url, options.accessToken);
+            for (const std::string &font : fonts) {
+                for (const GlyphRange &range : options.glyphRanges) {
+                    resources.push_back({ ResourceType::Glyphs, GlyphPBF::getURL(glyphURL, font, range) });
+                }
+            }
+        }
+    } catch (const std::exception &ex) {
+        Log::Warning(Event::ParseStyle, "failed to load offline style: %s", ex.what());
+        progress.failed++;
+        return;
+    }
+
+    add(std::move(resources));
+
+    for (const util::ptr<StyleSource> &source : sources) {
+        const util::ptr<SourceInfo> info = source->info;
+        if (info->url.empty()) {
+            addTiles(*info);
+            continue;
+        }
+
+        std::string url;
+        try {
+            url = util::mapbox::normalizeSourceURL(info->url, options.accessToken);
+        } catch (const std::exception &ex) {
+            Log::Warning(Event::General, "failed to load offline source: %s", ex.what());
+            continue;
+        }
+
+        if (seen.insert(url).second) {
+            progress.total++;
+            load({ ResourceType::JSON, url }, [this, info](const Response &tileJSON) {
+                loadTileJSON(info, tileJSON);
+            });
+        }
+    }
+}
+
+void OfflineRegion::loadTileJSON(const util::ptr<SourceInfo> &info, const Response &res) {
+    rapidjson::Document d;
+    const std::string json = res.data.str();
+    d.Parse<0>(json.c_str());
+
+    if (d.HasParseError()) {
+        Log::Warning(Event::General, "invalid offline source TileJSON");
+        progress.failed++;
+        return;
+    }
+
+    info->parseTileJSONProperties(d);
+    addTiles(*info);
+}
+
+void OfflineRegion::addTiles(const SourceInfo &info) {
+    if (info.type != SourceType::Vector && info.type != SourceType::Raster) {
+        return;
+    }
+
+    std::vector<Resource> resources;
+    const int minZoom = std::max<int>(options.minZoom, info.min_zoom);
+    const int maxZoom = std::min<int>(options.maxZoom, info.max_zoom);
+    for (int z = minZoom; z <= maxZoom; z++) {
+        for (const auto &tile : tiles(z)) {
+            const std::string url = info.tileURL(Tile::ID(z, tile.first, tile.second), options.pixelRatio);
+            if (!url.empty()) {
+                resources.push_back({ ResourceType::Tile, url });
+            }
+        }
+    }
+
+    add(std::move(resources));
+}
+
+void OfflineRegion::add(std::vector<Resource> &&resources) {
+    std::unique_ptr<OfflineLookupBaton> baton { new OfflineLookupBaton };
+    baton->region = shared_from_this();
+    std::vector<std::string> urls;
+    for (const Resource &resource : resources) {
+        if (seen.insert(resource.url).second) {
+            baton->types.emplace(resource.url, resource.type);
+            urls.push_back(resource.url);
+        }
+    }
+
+    if (urls.empty()) {
+        checkDone();
+        return;
+    }
+
+    progress.total += urls.size();
+    if (store) {
+        pending++;
+        store->getUnpinned(std::move(urls), &OfflineRegion::addUnpinned, baton.release());
+    } else {
+        addUnpinned(std::move(urls), baton.release());
+    }
+}
+
+void OfflineRegion::addUnpinned(std::vector<std::string> &&urls, void *ptr) {
+    std::unique_ptr<OfflineLookupBaton> baton { static_cast<OfflineLookupBaton *>(ptr) };
+    util::ptr<OfflineRegion> region = baton->region.lock();
+    if (!region || region->stopped) {
+        return;
+    }
+
+    if (region->store) {
+        region->pending--;
+    }
+
+    const size_t skipped = baton->types.size() - urls.size();
+    for (const std::string &url : urls) {
+        region->queue.push_back({ baton->types[url], url });
+    }
+
+    if (skipped) {
+        region->progress.completed += skipped;
+        if (region->callback) {
+            region->callback(region->progress);
+        }
+    }
+
+    region->pump();
+    region->checkDone();
+}
+
+void OfflineRegion::finished(const Resource &resource, const Response &res) {
+    progress.completed++;
+    if (res.code != 200) {
+        progress.failed++;
+    } else if (store) {
+        store->pin(resource.url);
+    }
+
+    if (callback) {
+        callback(progress);
+    }
+
+    pump();
+    checkDone();
+}
+
+void OfflineRegion::pump() {
+    while (!stopped && active < options.concurrency && !queue.empty()) {
+        const Resource resource = queue.front();
+        queue.pop_front();
+        load(resource, nullptr);
+    }
+}
+
+void OfflineRegion::checkDone() {
+    if (stopped || progress.done || active || pending || !queue.empty()) {
+        return;
+    }
+
+    progress.done = true;
+    stopped = true;
+    if (store) {
+        store->endBulkWrites();
+    }
+    if (callback) {
+        callback(progress);
+    }
+}
+
+}
@@ -18,7 +18,7 @@ void RasterTileData::parse() {
         return;
     }
 
-    if (bucket.setImage(data)) {
+    if (bucket.setImage(data.str())) {
         state = State::parsed;
     } else {
         state = State::invalid;
@@ -32,3 +32,8 @@ void RasterTileData::render(Painter &painter, util::ptr<StyleLayer> layer_desc,
 bool RasterTileData::hasData(StyleLayer const& /*layer_desc*/) const {
     return bucket.hasData();
 }
+
+size_t RasterTileData::bytes() const {
+    // Decoded images are RGBA.
+    return TileData::bytes() + bucket.raster.width * bucket.raster.height * 4;
+}
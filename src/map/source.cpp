@@ -46,7 +46,8 @@ void Source::load(Map& map, FileSource& fileSource) {
         }
 
         rapidjson::Document d;
-        d.Parse<0>(res.data.c_str());
+        const std::string json = res.data.str();
+        d.Parse<0>(json.c_str());
 
         if (d.HasParseError()) {
             Log::Warning(Event::General, "invalid source TileJSON");
@@ -184,6 +185,17 @@ TileData::State Source::addTile(Map& map, FileSource& fileSource, const Tile::ID
         new_tile.data.reset();
     }
 
+    if (!new_tile.data) {
+        // Reuse tile data that we parsed before it went out of view.
+        new_tile.data = cache.get(normalized_id);
+        if (new_tile.data && new_tile.data->outdated) {
+            new_tile.data.reset();
+        }
+        if (new_tile.data) {
+            tile_data.emplace(new_tile.data->id, new_tile.data);
+        }
+    }
+
     if (!new_tile.data) {
         // If we don't find working tile data, we're just going to load it.
         if (info->type == SourceType::Vector) {
@@ -296,10 +308,32 @@ bool Source::updateTiles(Map& map, FileSource& fileSource) {
     // parent or child tiles that are *already* loaded.
     std::forward_list<Tile::ID> retain(required);
 
+    // Revalidating a stale tile may have returned different data. Drop those tiles so that they
+    // are loaded again below; their parent or child tiles are shown until they are parsed.
+    util::erase_if(tiles, [this, &changed](std::pair<const Tile::ID, std::unique_ptr<Tile>> &pair) {
+        const util::ptr<TileData> &data = pair.second->data;
+        if (data && data->outdated) {
+            tile_data.erase(data->id);
+            data->cancel();
+            changed = true;
+            return true;
+        }
+        return false;
+    });
+
+    // The required tiles are sorted by their distance from the center of the viewport; parse
+    // the ones closest to the center first.
+    double priority = 0;
+
     // Add existing child/parent tiles if the actual tile is not yet loaded
     for (const Tile::ID& id : required) {
         const TileData::State state = addTile(map, fileSource, id);
 
+        auto tile_it = tiles.find(id);
+        if (tile_it != tiles.end() && tile_it->second->data) {
+            tile_it->second->data->setPriority(priority++);
+        }
+
         if (state != TileData::State::parsed) {
             // The tile we require is not yet loaded. Try to find a parent or
             // child tile that we already have.
@@ -334,8 +368,11 @@ bool Source::updateTiles(Map& map, FileSource& fileSource) {
         return obsolete;
     });
 
-    // Remove all the expired pointers from the set.
-    util::erase_if(tile_data, [&retain_data](std::pair<const Tile::ID, std::weak_ptr<TileData>> &pair) {
+    cache.setMaxBytes(map.getTileCacheSize());
+
+    // Remove all the expired pointers from the set. Tiles that finished parsing are moved to
+    // the cache instead of being discarded.
+    util::erase_if(tile_data, [this, &retain_data](std::pair<const Tile::ID, std::weak_ptr<TileData>> &pair) {
         const util::ptr<TileData> tile = pair.second.lock();
         if (!tile) {
             return true;
@@ -343,7 +380,11 @@ bool Source::updateTiles(Map& map, FileSource& fileSource) {
 
         bool obsolete = retain_data.find(tile->id) == retain_data.end();
         if (obsolete) {
-            tile->cancel();
+            if (tile->state == TileData::State::parsed) {
+                cache.add(tile->id, tile);
+            } else {
+                tile->cancel();
+            }
             return true;
         } else {
             return false;
@@ -35,12 +35,7 @@ Sprite::Sprite(const Key &, const std::string& base_url, float pixelRatio_)
       jsonURL(base_url + (pixelRatio_ > 1 ? "@2x" : "") + ".json"),
       raster(),
       loadedImage(false),
-      loadedJSON(false),
-      future(promise.get_future()) {
-}
-
-void Sprite::waitUntilLoaded() const {
-    future.wait();
+      loadedJSON(false) {
 }
 
 Sprite::operator bool() const {
@@ -56,7 +51,7 @@ void Sprite::load(FileSource& fileSource) {
         // Treat a non-existent sprite as a successfully loaded empty sprite.
         loadedImage = true;
         loadedJSON = true;
-        promise.set_value();
+        finished = true;
         return;
     }
 
@@ -64,27 +59,25 @@ void Sprite::load(FileSource& fileSource) {
 
     fileSource.request(ResourceType::JSON, jsonURL)->onload([sprite](const Response &res) {
         if (res.code == 200) {
-            sprite->body = res.data;
+            sprite->body = res.data.str();
             sprite->parseJSON();
             sprite->complete();
         } else {
             Log::Warning(Event::Sprite, "Failed to load sprite info: Error %d: %s", res.code, res.message.c_str());
-            if (!sprite->future.valid()) {
-                sprite->promise.set_exception(std::make_exception_ptr(std::runtime_error(res.message)));
-            }
+            // Tiles waiting for the sprite are parsed without icons.
+            sprite->finish();
         }
     });
 
     fileSource.request(ResourceType::Image, spriteURL)->onload([sprite](const Response &res) {
         if (res.code == 200) {
-            sprite->image = res.data;
+            sprite->image = res.data.str();
             sprite->parseImage();
             sprite->complete();
         } else {
             Log::Warning(Event::Sprite, "Failed to load sprite image: Error %d: %s", res.code, res.message.c_str());
-            if (!sprite->future.valid()) {
-                sprite->promise.set_exception(std::make_exception_ptr(std::runtime_error(res.message)));
-            }
+            // Tiles waiting for the sprite are parsed without icons.
+            sprite->finish();
         }
     });
 }
@@ -92,8 +85,32 @@ void Sprite::load(FileSource& fileSource) {
 void Sprite::complete() {
     if (loadedImage && loadedJSON) {
         Log::Info(Event::Sprite, "loaded %s", spriteURL.c_str());
-        promise.set_value();
+        finish();
+    }
+}
+
+void Sprite::finish() {
+    std::vector<std::function<void()>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (finished) {
+            return;
+        }
+        finished = true;
+        pending.swap(callbacks);
+    }
+
+    for (const auto &callback : pending) {
+        callback();
+    }
+}
+
+bool Sprite::isLoaded(const std::function<void()> &callback) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!finished) {
+        callbacks.push_back(callback);
     }
+    return finished;
 }
 
 bool Sprite::isLoaded() const {
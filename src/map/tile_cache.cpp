@@ -0,0 +1,68 @@
+#include <mbgl/map/tile_cache.hpp>
+#include <mbgl/map/tile_data.hpp>
+
+#include <cassert>
+
+using namespace mbgl;
+
+TileCache::TileCache(size_t maxBytes_)
+    : maxBytes(maxBytes_) {
+}
+
+void TileCache::setMaxBytes(size_t maxBytes_) {
+    maxBytes = maxBytes_;
+    evict();
+}
+
+void TileCache::add(const Tile::ID &id, const util::ptr<TileData> &data) {
+    if (!data) {
+        return;
+    }
+
+    // Replace an existing entry for the same tile.
+    get(id);
+
+    const size_t size = data->bytes();
+    if (size > maxBytes) {
+        return;
+    }
+
+    auto position = order.insert(order.end(), id);
+    entries.emplace(id, Entry { data, size, position });
+    bytes += size;
+
+    evict();
+}
+
+util::ptr<TileData> TileCache::get(const Tile::ID &id) {
+    auto it = entries.find(id);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+
+    util::ptr<TileData> data = std::move(it->second.data);
+    bytes -= it->second.bytes;
+    order.erase(it->second.position);
+    entries.erase(it);
+    return data;
+}
+
+bool TileCache::has(const Tile::ID &id) const {
+    return entries.find(id) != entries.end();
+}
+
+void TileCache::clear() {
+    order.clear();
+    entries.clear();
+    bytes = 0;
+}
+
+void TileCache::evict() {
+    while (bytes > maxBytes && !order.empty()) {
+        auto it = entries.find(order.front());
+        assert(it != entries.end());
+        bytes -= it->second.bytes;
+        entries.erase(it);
+        order.pop_front();
+    }
+}
@@ -2,10 +2,9 @@
 #include <mbgl/map/map.hpp>
 #include <mbgl/style/style_source.hpp>
 
-#include <mbgl/util/token.hpp>
 #include <mbgl/util/string.hpp>
 #include <mbgl/storage/file_source.hpp>
-#include <mbgl/util/uv_detail.hpp>
+#include <mbgl/util/work_scheduler.hpp>
 
 using namespace mbgl;
 
@@ -28,25 +27,23 @@ const std::string TileData::toString() const {
     return util::sprintf<32>("[tile %d/%d/%d]", id.z, id.x, id.y);
 }
 
+size_t TileData::bytes() const {
+    return data.size();
+}
+
 void TileData::request(FileSource& fileSource) {
     if (source->tiles.empty())
         return;
 
-    std::string url = source->tiles[(id.x + id.y) % source->tiles.size()];
-    url = util::replaceTokens(url, [&](const std::string &token) -> std::string {
-        if (token == "z") return std::to_string(id.z);
-        if (token == "x") return std::to_string(id.x);
-        if (token == "y") return std::to_string(id.y);
-        if (token == "ratio") return (map.getState().getPixelRatio() > 1.0 ? "@2x" : "");
-        return "";
-    });
+    url = source->tileURL(id, map.getState().getPixelRatio());
 
     state = State::loading;
 
     // Note: Somehow this feels slower than the change to request_http()
     std::weak_ptr<TileData> weak_tile = shared_from_this();
     req = fileSource.request(ResourceType::Tile, url);
-    req->onload([weak_tile, url](const Response &res) {
+    req->setPriority(priority);
+    auto handler = [weak_tile, &fileSource](const Response &res) {
         util::ptr<TileData> tile = weak_tile.lock();
         if (!tile || tile->state == State::obsolete) {
             // noop. Tile is obsolete and we're now just waiting for the refcount
@@ -54,22 +51,40 @@ void TileData::request(FileSource& fileSource) {
             return;
         }
 
-        // Clear the request object.
-        tile->req.reset();
+        // Clear the request object. A stale response is followed by the revalidated one.
+        if (!res.stale) {
+            tile->req.reset();
+        }
 
         if (res.code == 200) {
-            tile->state = State::loaded;
+            if (tile->state == State::loading) {
+                tile->state = State::loaded;
 
-            tile->data = res.data;
+                tile->data = res.data;
 
-            // Schedule tile parsing in another thread
-            tile->reparse();
-        } else {
+                tile->loaded(fileSource);
+            } else if (!res.stale && tile->data != res.data) {
+                // The revalidated body differs from the stale one that we're already parsing or
+                // rendering. The buffers may be in use, so the Source replaces this tile instead.
+                tile->outdated = true;
+                tile->map.update();
+            }
+        } else if (!res.stale) {
 #if defined(DEBUG)
-            fprintf(stderr, "[%s] tile loading failed: %ld, %s\n", url.c_str(), res.code, res.message.c_str());
+            fprintf(stderr, "[%s] tile loading failed: %ld, %s\n", tile->url.c_str(), res.code, res.message.c_str());
 #endif
         }
-    });
+    };
+
+    // Register for stale responses first: if the final response is already there, the onload
+    // callback is invoked right away and clears the request object.
+    req->onpreliminary(handler);
+    req->onload(handler);
+}
+
+void TileData::loaded(FileSource &) {
+    // Schedule tile parsing in another thread
+    reparse();
 }
 
 void TileData::cancel() {
@@ -79,20 +94,36 @@ void TileData::cancel() {
             req->cancel();
             req.reset();
         }
+        if (work) {
+            // Drop the parse job if it hasn't been started yet.
+            work->cancel();
+            work.reset();
+        }
+    }
+}
+
+void TileData::setPriority(double priority_) {
+    priority = priority_;
+    if (req) {
+        req->setPriority(priority);
+    }
+    if (work) {
+        work->setPriority(priority);
     }
 }
 
 void TileData::reparse()
 {
-    // We're creating a new work request. The work request deletes itself after it executed
-    // the after work handler
-    new uv::work<util::ptr<TileData>>(
-        map.getWorker(),
-        [](util::ptr<TileData> &tile) {
+    util::ptr<TileData> tile = shared_from_this();
+    work = map.getWorker().add(
+        priority,
+        [tile]() {
             tile->parse();
         },
-        [](util::ptr<TileData> &tile) {
-            tile->map.update();
-        },
-        shared_from_this());
+        [tile](bool completed) {
+            if (completed) {
+                tile->afterParse();
+                tile->map.update();
+            }
+        });
 }
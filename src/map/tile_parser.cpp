@@ -16,10 +16,12 @@
 #include <mbgl/text/collision.hpp>
 #include <mbgl/text/glyph.hpp>
 #include <mbgl/map/map.hpp>
+#include <mbgl/util/work_scheduler.hpp>
 
 #include <mbgl/util/std.hpp>
 #include <mbgl/util/utf.hpp>
 
+#include <algorithm>
 #include <locale>
 
 namespace mbgl {
@@ -29,13 +31,13 @@ namespace mbgl {
 // its header file.
 TileParser::~TileParser() = default;
 
-TileParser::TileParser(const std::string &data, VectorTileData &tile_,
+TileParser::TileParser(const util::Blob &data, VectorTileData &tile_,
                        const util::ptr<const Style> &style_,
                        GlyphAtlas & glyphAtlas_,
                        const util::ptr<GlyphStore> &glyphStore_,
                        SpriteAtlas & spriteAtlas_,
                        const util::ptr<Sprite> &sprite_)
-    : vector_data(pbf((const uint8_t *)data.data(), data.size())),
+    : vector_data(pbf((const uint8_t *)data.data(), data.size()), arena),
       tile(tile_),
       style(style_),
       glyphAtlas(glyphAtlas_),
@@ -50,13 +52,50 @@ TileParser::TileParser(const std::string &data, VectorTileData &tile_,
     assert(collision);
 }
 
-void TileParser::parse() {
-    parseStyleLayers(style->layers);
+bool TileParser::parse() {
+    pending = false;
+
+    std::vector<util::ptr<StyleBucket>> bucket_descs;
+    parseStyleLayers(style->layers, bucket_descs);
+
+    // Fill and line buckets don't depend on each other, so each of them is built by a task of
+    // its own. Symbol buckets share the collision index and are placed in style order, so a
+    // single task builds them along with all other buckets.
+    std::vector<std::unique_ptr<Bucket>> buckets(bucket_descs.size());
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < bucket_descs.size(); i++) {
+        const StyleBucket &bucket_desc = *bucket_descs[i];
+        if (bucket_desc.render.is<StyleBucketFill>() || bucket_desc.render.is<StyleBucketLine>()) {
+            tasks.emplace_back([this, &bucket_descs, &buckets, i]() {
+                buckets[i] = createBucket(bucket_descs[i]);
+            });
+        }
+    }
+    tasks.emplace_back([this, &bucket_descs, &buckets]() {
+        for (size_t i = 0; i < bucket_descs.size(); i++) {
+            const StyleBucket &bucket_desc = *bucket_descs[i];
+            if (!bucket_desc.render.is<StyleBucketFill>() && !bucket_desc.render.is<StyleBucketLine>()) {
+                buckets[i] = createBucket(bucket_descs[i]);
+            }
+        }
+    });
+
+    tile.map.getWorker().parallel(tasks);
+
+    for (size_t i = 0; i < bucket_descs.size(); i++) {
+        if (buckets[i]) {
+            // Bucket creation might fail because the data tile may not
+            // contain any data that falls into this bucket.
+            tile.buckets[bucket_descs[i]->name] = std::move(buckets[i]);
+        }
+    }
+
+    return !pending;
 }
 
 bool TileParser::obsolete() const { return tile.state == TileData::State::obsolete; }
 
-void TileParser::parseStyleLayers(util::ptr<StyleLayerGroup> group) {
+void TileParser::parseStyleLayers(util::ptr<StyleLayerGroup> group, std::vector<util::ptr<StyleBucket>> &bucket_descs) {
     if (!group) {
         return;
     }
@@ -72,20 +111,19 @@ void TileParser::parseStyleLayers(util::ptr<StyleLayerGroup> group) {
             continue;
         } else if (layer_desc->layers) {
             // This is a layer group.
-            parseStyleLayers(layer_desc->layers);
+            parseStyleLayers(layer_desc->layers, bucket_descs);
         }
         if (layer_desc->bucket) {
             // This is a singular layer. Check if this bucket already exists. If not,
-            // parse this bucket.
-            auto bucket_it = tile.buckets.find(layer_desc->bucket->name);
-            if (bucket_it == tile.buckets.end()) {
+            // schedule it for parsing.
+            const std::string &name = layer_desc->bucket->name;
+            auto bucket_it = tile.buckets.find(name);
+            if (bucket_it == tile.buckets.end() &&
+                std::find_if(bucket_descs.begin(), bucket_descs.end(), [&name](const util::ptr<StyleBucket> &desc) {
+                    return desc->name == name;
+                }) == bucket_descs.end()) {
                 // We need to create this bucket since it doesn't exist yet.
-                std::unique_ptr<Bucket> bucket = createBucket(layer_desc->bucket);
-                if (bucket) {
-                    // Bucket creation might fail because the data tile may not
-                    // contain any data that falls into this bucket.
-                    tile.buckets[layer_desc->bucket->name] = std::move(bucket);
-                }
+                bucket_descs.push_back(layer_desc->bucket);
             }
         } else {
             fprintf(stderr, "[WARNING] layer '%s' does not have child layers or buckets\n", layer_desc->id.c_str());
@@ -133,25 +171,32 @@ std::unique_ptr<Bucket> TileParser::createBucket(util::ptr<StyleBucket> bucket_d
 template <class Bucket>
 void TileParser::addBucketGeometries(Bucket& bucket, const VectorTileLayer& layer, const FilterExpression &filter) {
     FilteredVectorTileLayer filtered_layer(layer, filter);
-    for (pbf feature : filtered_layer) {
+    for (uint32_t feature : filtered_layer) {
         if (obsolete())
             return;
 
-        while (feature.next(4)) { // geometry
-            pbf geometry_pbf = feature.message();
-            if (geometry_pbf) {
-                bucket->addGeometry(geometry_pbf);
-            } else if (debug::tileParseWarnings) {
-                fprintf(stderr, "[WARNING] geometry is empty\n");
-            }
+        pbf geometry_pbf = layer.geometry(feature);
+        if (geometry_pbf) {
+            bucket->addGeometry(geometry_pbf);
+        } else if (debug::tileParseWarnings) {
+            fprintf(stderr, "[WARNING] geometry is empty\n");
         }
     }
 }
 
 std::unique_ptr<Bucket> TileParser::createFillBucket(const VectorTileLayer& layer, const FilterExpression &filter, const StyleBucketFill &fill) {
-    std::unique_ptr<FillBucket> bucket = std::make_unique<FillBucket>(tile.fillVertexBuffer, tile.triangleElementsBuffer, tile.lineElementsBuffer, fill);
+    // Build into buffers of our own so that other buckets can be built at the same time.
+    FillVertexBuffer vertexBuffer;
+    TriangleElementsBuffer triangleElementsBuffer;
+    LineElementsBuffer lineElementsBuffer;
+    std::unique_ptr<FillBucket> bucket = std::make_unique<FillBucket>(vertexBuffer, triangleElementsBuffer, lineElementsBuffer, fill);
     addBucketGeometries(bucket, layer, filter);
-    return obsolete() ? nullptr : std::move(bucket);
+    if (obsolete()) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    return std::make_unique<FillBucket>(tile.fillVertexBuffer, tile.triangleElementsBuffer, tile.lineElementsBuffer, std::move(*bucket));
 }
 
 std::unique_ptr<Bucket> TileParser::createRasterBucket(const util::ptr<Texturepool> &texturepool, const StyleBucketRaster &raster) {
@@ -160,14 +205,40 @@ std::unique_ptr<Bucket> TileParser::createRasterBucket(const util::ptr<Texturepo
 }
 
 std::unique_ptr<Bucket> TileParser::createLineBucket(const VectorTileLayer& layer, const FilterExpression &filter, const StyleBucketLine &line) {
-    std::unique_ptr<LineBucket> bucket = std::make_unique<LineBucket>(tile.lineVertexBuffer, tile.triangleElementsBuffer, tile.pointElementsBuffer, line);
+    // Build into buffers of our own so that other buckets can be built at the same time.
+    LineVertexBuffer vertexBuffer;
+    TriangleElementsBuffer triangleElementsBuffer;
+    PointElementsBuffer pointElementsBuffer;
+    std::unique_ptr<LineBucket> bucket = std::make_unique<LineBucket>(vertexBuffer, triangleElementsBuffer, pointElementsBuffer, line);
     addBucketGeometries(bucket, layer, filter);
-    return obsolete() ? nullptr : std::move(bucket);
+    if (obsolete()) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    return std::make_unique<LineBucket>(tile.lineVertexBuffer, tile.triangleElementsBuffer, tile.pointElementsBuffer, std::move(*bucket));
 }
 
 std::unique_ptr<Bucket> TileParser::createSymbolBucket(const VectorTileLayer& layer, const FilterExpression &filter, const StyleBucketSymbol &symbol) {
+    if (pending) {
+        // Symbols are placed in style order, so this bucket has to wait for the pending one.
+        return nullptr;
+    }
+
+    // Reparse the tile in the worker threads once the missing glyphs or sprite have loaded.
+    std::weak_ptr<TileData> weak_tile = tile.shared_from_this();
+    auto callback = [weak_tile]() {
+        util::ptr<TileData> tile_ = weak_tile.lock();
+        if (tile_ && tile_->state == TileData::State::loaded) {
+            tile_->reparse();
+        }
+    };
+
     std::unique_ptr<SymbolBucket> bucket = std::make_unique<SymbolBucket>(symbol, *collision);
-    bucket->addFeatures(layer, filter, tile.id, spriteAtlas, *sprite, glyphAtlas, *glyphStore);
+    if (!bucket->addFeatures(layer, filter, tile.id, spriteAtlas, *sprite, glyphAtlas, *glyphStore, callback)) {
+        pending = true;
+        return nullptr;
+    }
     return obsolete() ? nullptr : std::move(bucket);
 }
 
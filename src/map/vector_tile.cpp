@@ -17,7 +17,8 @@ std::ostream& mbgl::operator<<(std::ostream& os, const FeatureType& type) {
     }
 }
 
-VectorTileFeature::VectorTileFeature(pbf feature, const VectorTileLayer& layer) {
+VectorTileFeature::VectorTileFeature(pbf feature, const VectorTileLayer& layer)
+    : properties(layer.values.get_allocator()) {
     while (feature.next()) {
         if (feature.tag == 1) { // id
             id = feature.varint<uint64_t>();
@@ -53,6 +54,18 @@ VectorTileFeature::VectorTileFeature(pbf feature, const VectorTileLayer& layer)
 }
 
 
+VectorTileFeature::VectorTileFeature(const VectorTileLayer& layer, uint32_t index)
+    : type(layer.features.types[index]),
+      properties(layer.values.get_allocator()),
+      geometry(layer.geometry(index)) {
+    const uint32_t *tags = layer.features.tagsBegin(index);
+    const uint32_t *end = layer.features.tagsEnd(index);
+    for (; tags != end; tags += 2) {
+        properties.emplace(layer.keys[tags[0]], layer.values[tags[1]]);
+    }
+}
+
+
 std::ostream& mbgl::operator<<(std::ostream& os, const VectorTileFeature& feature) {
     os << "Feature(" << feature.id << "): " << feature.type << std::endl;
     for (const auto& prop : feature.properties) {
@@ -62,13 +75,11 @@ std::ostream& mbgl::operator<<(std::ostream& os, const VectorTileFeature& featur
 }
 
 
-VectorTile::VectorTile() {}
-
-
-VectorTile::VectorTile(pbf tile) {
+VectorTile::VectorTile(pbf tile, util::Arena &arena)
+    : layers(std::less<std::string>(), arena) {
     while (tile.next()) {
         if (tile.tag == 3) { // layer
-            VectorTileLayer layer(tile.message());
+            VectorTileLayer layer(tile.message(), arena);
             layers.emplace(layer.name, std::forward<VectorTileLayer>(layer));
         } else {
             tile.skip();
@@ -76,15 +87,19 @@ VectorTile::VectorTile(pbf tile) {
     }
 }
 
-VectorTile& VectorTile::operator=(VectorTile && other) {
-    if (this != &other) {
-        layers.swap(other.layers);
-    }
-    return *this;
+VectorTileFeatureTable::VectorTileFeatureTable(util::Arena &arena)
+    : types(arena),
+      tag_offsets(1, 0, arena),
+      tags(arena),
+      geometry_offsets(arena) {
 }
 
-VectorTileLayer::VectorTileLayer(pbf layer) : data(layer) {
-    std::vector<std::string> stacks;
+VectorTileLayer::VectorTileLayer(pbf layer, util::Arena &arena)
+    : data(layer),
+      keys(arena),
+      key_index(0, std::hash<std::string>(), std::equal_to<std::string>(), arena),
+      values(arena),
+      features(arena) {
 
     while (layer.next()) {
         if (layer.tag == 1) { // name
@@ -96,119 +111,273 @@ VectorTileLayer::VectorTileLayer(pbf layer) : data(layer) {
             values.emplace_back(std::move(parseValue(layer.message())));
         } else if (layer.tag == 5) { // extent
             extent = layer.varint();
+        } else if (layer.tag == 2) { // feature
+            addFeature(layer.message());
         } else {
             layer.skip();
         }
     }
+
+    // Keys and values may follow the features in the layer, so we can only
+    // validate the tag indices once the entire layer has been read.
+    const util::ArenaVector<uint32_t> &tags = features.tags;
+    for (size_t i = 0; i < tags.size(); i += 2) {
+        if (keys.size() <= tags[i]) {
+            throw std::runtime_error("feature referenced out of range key");
+        }
+        if (values.size() <= tags[i + 1]) {
+            throw std::runtime_error("feature referenced out of range value");
+        }
+    }
+}
+
+void VectorTileLayer::addFeature(pbf feature) {
+    FeatureType type = FeatureType::Unknown;
+    const uint8_t *geometry_begin = nullptr;
+    const uint8_t *geometry_end = nullptr;
+
+    while (feature.next()) {
+        if (feature.tag == 2) { // tags
+            // tags are packed varints. They should have an even length.
+            pbf tags = feature.message();
+            while (tags) {
+                features.tags.push_back(tags.varint());
+                if (!tags) {
+                    throw std::runtime_error("uneven number of feature tag ids");
+                }
+                features.tags.push_back(tags.varint());
+            }
+        } else if (feature.tag == 3) { // type
+            type = FeatureType(feature.varint());
+        } else if (feature.tag == 4) { // geometry
+            pbf geometry_pbf = feature.message();
+            geometry_begin = geometry_pbf.data;
+            geometry_end = geometry_pbf.end;
+        } else {
+            feature.skip();
+        }
+    }
+
+    features.types.push_back(type);
+    features.tag_offsets.push_back(uint32_t(features.tags.size()));
+    if (geometry_begin) {
+        features.geometry_offsets.push_back(uint32_t(geometry_begin - data.data));
+        features.geometry_offsets.push_back(uint32_t(geometry_end - data.data));
+    } else {
+        features.geometry_offsets.push_back(0);
+        features.geometry_offsets.push_back(0);
+    }
+}
+
+pbf VectorTileLayer::geometry(uint32_t index) const {
+    const uint32_t begin = features.geometry_offsets[2 * index];
+    const uint32_t end = features.geometry_offsets[2 * index + 1];
+    return pbf(data.data + begin, end - begin);
 }
 
 FilteredVectorTileLayer::FilteredVectorTileLayer(const VectorTileLayer& layer_, const FilterExpression &filterExpression_)
     : layer(layer_),
-      filterExpression(filterExpression_) {
+      filterExpression(filterExpression_, layer_) {
 }
 
 FilteredVectorTileLayer::iterator FilteredVectorTileLayer::begin() const {
-    return iterator(*this, layer.data);
+    return iterator(*this, 0);
 }
 
 FilteredVectorTileLayer::iterator FilteredVectorTileLayer::end() const {
-    return iterator(*this, pbf(layer.data.end, 0));
+    return iterator(*this, layer.features.size());
 }
 
-FilteredVectorTileLayer::iterator::iterator(const FilteredVectorTileLayer& parent_, const pbf& data_)
-    : parent(parent_),
-      feature(pbf()),
-      data(data_) {
-    operator++();
-}
+namespace {
 
-VectorTileTagExtractor::VectorTileTagExtractor(const VectorTileLayer &layer) : layer_(layer) {}
+// Provides the value of a single filter key, which is all that's needed to
+// evaluate one comparison of a filter expression.
+class FilterValueExtractor {
+public:
+    FilterValueExtractor(const Value *value_) : value(value_) {}
 
+    mapbox::util::optional<Value> getValue(const std::string &) const {
+        return value ? mapbox::util::optional<Value>(*value) : mapbox::util::optional<Value>();
+    }
+
+private:
+    const Value *value;
+};
 
-void VectorTileTagExtractor::setTags(const pbf &pbf) {
-    tags_ = pbf;
 }
 
-mapbox::util::optional<Value> VectorTileTagExtractor::getValue(const std::string &key) const {
-    if (key == "$type") {
-        return Value(uint64_t(type_));
+struct CompiledFilterExpression::Compiler : public mapbox::util::static_visitor<uint32_t> {
+    CompiledFilterExpression &compiled;
+    const FilterExpression &expression;
+
+    Compiler(CompiledFilterExpression &compiled_, const FilterExpression &expression_)
+        : compiled(compiled_), expression(expression_) {}
+
+    uint32_t operator()(const NullExpression &) const {
+        Node node;
+        node.type = Node::Type::Constant;
+        node.missing = true;
+        return add(std::move(node));
     }
 
-    mapbox::util::optional<Value> value;
+    uint32_t operator()(const AnyExpression &e) const {
+        return compound(Node::Type::Any, e.expressions);
+    }
 
-    auto field_it = layer_.key_index.find(key);
-    if (field_it != layer_.key_index.end()) {
-        const uint32_t filter_key = field_it->second;
+    uint32_t operator()(const AllExpression &e) const {
+        return compound(Node::Type::All, e.expressions);
+    }
 
-        // Now loop through all the key/value pair tags.
-        // tags are packed varints. They should have an even length.
-        pbf tags_pbf = tags_;
-        uint32_t tag_key, tag_val;
-        while (tags_pbf) {
-            tag_key = tags_pbf.varint();
-            if (!tags_pbf) {
-                // This should not happen; otherwise the vector tile is invalid.
-                fprintf(stderr, "[WARNING] uneven number of feature tag ids\n");
-                return value;
-            }
-            // Note: We need to run this command in all cases, even if the keys don't match.
-            tag_val = tags_pbf.varint();
+    uint32_t operator()(const NoneExpression &e) const {
+        return compound(Node::Type::None, e.expressions);
+    }
 
-            if (tag_key == filter_key) {
-                if (layer_.values.size() > tag_val) {
-                    value = layer_.values[tag_val];
-                } else {
-                    fprintf(stderr, "[WARNING] feature references out of range value\n");
-                    break;
-                }
+    // All remaining expressions compare the value of a single key.
+    template <class E>
+    uint32_t operator()(const E &e) const {
+        Node node;
+        node.expression = &expression;
+
+        if (e.key == "$type") {
+            node.type = Node::Type::GeometryType;
+            for (uint64_t type = uint64_t(FeatureType::Unknown); type <= uint64_t(FeatureType::Polygon); ++type) {
+                const Value value(type);
+                node.results.push_back(mbgl::evaluate(expression, FilterValueExtractor(&value)));
             }
+            return add(std::move(node));
+        }
+
+        node.missing = mbgl::evaluate(expression, FilterValueExtractor(nullptr));
+
+        auto key_it = compiled.layer.key_index.find(e.key);
+        if (key_it == compiled.layer.key_index.end()) {
+            // None of the features in this layer has this key.
+            node.type = Node::Type::Constant;
+        } else {
+            node.type = Node::Type::Key;
+            node.key = key_it->second;
+            node.results.resize(compiled.layer.values.size(), -1);
         }
+        return add(std::move(node));
+    }
+
+    uint32_t compound(Node::Type type, const std::vector<FilterExpression> &expressions) const {
+        Node node;
+        node.type = type;
+        for (const FilterExpression &child : expressions) {
+            node.children.push_back(compiled.compile(child));
+        }
+        return add(std::move(node));
+    }
+
+    uint32_t add(Node &&node) const {
+        compiled.nodes.push_back(std::move(node));
+        return uint32_t(compiled.nodes.size() - 1);
     }
+};
 
-    return value;
+CompiledFilterExpression::CompiledFilterExpression(const FilterExpression &expression, const VectorTileLayer &layer_)
+    : layer(layer_) {
+    root = compile(expression);
 }
 
-void VectorTileTagExtractor::setType(FeatureType type) {
-    type_ = type;
+uint32_t CompiledFilterExpression::compile(const FilterExpression &expression) {
+    return mapbox::util::apply_visitor(Compiler(*this, expression), expression);
 }
 
-template bool mbgl::evaluate(const FilterExpression&, const VectorTileTagExtractor&);
+bool CompiledFilterExpression::evaluate(uint32_t feature) const {
+    return evaluate(nodes[root], feature);
+}
 
-void FilteredVectorTileLayer::iterator::operator++() {
-    valid = false;
+bool CompiledFilterExpression::evaluate(const Node &node, uint32_t feature) const {
+    switch (node.type) {
+        case Node::Type::Constant:
+            return node.missing;
 
-    const FilterExpression &expression = parent.filterExpression;
+        case Node::Type::GeometryType: {
+            const size_t type = size_t(layer.features.types[feature]);
+            if (type < node.results.size()) {
+                return node.results[type];
+            }
 
-    while (data.next(2)) { // feature
-        feature = data.message();
-        pbf feature_pbf = feature;
+            // Types that the spec doesn't define are compared like any other value.
+            const Value value(uint64_t(layer.features.types[feature]));
+            return mbgl::evaluate(*node.expression, FilterValueExtractor(&value));
+        }
 
-        VectorTileTagExtractor extractor(parent.layer);
+        case Node::Type::Key: {
+            // If a feature has the same key more than once, the last value wins.
+            const uint32_t *value = nullptr;
+            const uint32_t *end = layer.features.tagsEnd(feature);
+            for (const uint32_t *tags = layer.features.tagsBegin(feature); tags != end; tags += 2) {
+                if (tags[0] == node.key) {
+                    value = tags + 1;
+                }
+            }
 
-        // Retrieve the basic information
-        while (feature_pbf.next()) {
-            if (feature_pbf.tag == 2) { // tags
-                extractor.setTags(feature_pbf.message());
-            } else if (feature_pbf.tag == 3) { // geometry type
-                extractor.setType(FeatureType(feature_pbf.varint()));
-            } else {
-                feature_pbf.skip();
+            if (!value) {
+                return node.missing;
             }
-        }
 
-        if (evaluate(expression, extractor)) {
-            valid = true;
-            return; // data loop
-        } else {
-            valid = false;
+            int8_t &result = node.results[*value];
+            if (result < 0) {
+                result = mbgl::evaluate(*node.expression, FilterValueExtractor(&layer.values[*value]));
+            }
+            return result;
         }
+
+        case Node::Type::Any:
+            for (uint32_t child : node.children) {
+                if (evaluate(nodes[child], feature)) {
+                    return true;
+                }
+            }
+            return false;
+
+        case Node::Type::All:
+            for (uint32_t child : node.children) {
+                if (!evaluate(nodes[child], feature)) {
+                    return false;
+                }
+            }
+            return true;
+
+        case Node::Type::None:
+            for (uint32_t child : node.children) {
+                if (evaluate(nodes[child], feature)) {
+                    return false;
+                }
+            }
+            return true;
+    }
+
+    return false;
+}
+
+FilteredVectorTileLayer::iterator::iterator(const FilteredVectorTileLayer& parent_, uint32_t index_)
+    : parent(parent_),
+      index(index_) {
+    advance();
+}
+
+void FilteredVectorTileLayer::iterator::operator++() {
+    ++index;
+    advance();
+}
+
+void FilteredVectorTileLayer::iterator::advance() {
+    const uint32_t size = parent.layer.features.size();
+
+    // Skip to the next feature that matches the filter.
+    while (index < size && !parent.filterExpression.evaluate(index)) {
+        ++index;
     }
 }
 
 bool FilteredVectorTileLayer::iterator::operator!=(const iterator& other) const {
-    return !(data.data == other.data.data && data.end == other.data.end && valid == other.valid);
+    return index != other.index;
 }
 
-const pbf& FilteredVectorTileLayer::iterator:: operator*() const {
-    return feature;
+uint32_t FilteredVectorTileLayer::iterator::operator*() const {
+    return index;
 }
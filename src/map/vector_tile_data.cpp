@@ -4,10 +4,101 @@
 #include <mbgl/map/map.hpp>
 #include <mbgl/style/style_layer.hpp>
 #include <mbgl/style/style_bucket.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/renderer/fill_bucket.hpp>
+#include <mbgl/renderer/line_bucket.hpp>
 #include <mbgl/geometry/glyph_atlas.hpp>
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/sqlite_store.hpp>
+#include <mbgl/platform/log.hpp>
+#include <mbgl/util/binary.hpp>
+#include <mbgl/util/string.hpp>
+
+#include <set>
+#include <unordered_map>
 
 using namespace mbgl;
 
+namespace {
+
+// Increase this when the serialized bucket format changes.
+const uint32_t bucketCacheVersion = 1;
+
+enum class CachedBucketType : uint8_t {
+    Fill = 1,
+    Line = 2,
+};
+
+struct FilterWriter : public mapbox::util::static_visitor<> {
+    util::BinaryWriter &writer;
+
+    FilterWriter(util::BinaryWriter &writer_) : writer(writer_) {}
+
+    void write(const Value &value) const {
+        writer.write<uint32_t>(value.get_type_index());
+        writer.write(toString(value));
+    }
+
+    void operator()(const NullExpression &) const {}
+
+    template <typename E>
+    void operator()(const E &e, decltype(e.value) * = nullptr) const {
+        writer.write(e.key);
+        write(e.value);
+    }
+
+    template <typename E>
+    void operator()(const E &e, decltype(e.values) * = nullptr) const {
+        writer.write(e.key);
+        writer.write<uint32_t>(e.values.size());
+        for (const Value &value : e.values) {
+            write(value);
+        }
+    }
+
+    template <typename E>
+    void operator()(const E &e, decltype(e.expressions) * = nullptr) const {
+        writer.write<uint32_t>(e.expressions.size());
+        for (const FilterExpression &expression : e.expressions) {
+            writeFilter(writer, expression);
+        }
+    }
+
+    static void writeFilter(util::BinaryWriter &writer, const FilterExpression &expression) {
+        writer.write<uint32_t>(expression.get_type_index());
+        mapbox::util::apply_visitor(FilterWriter(writer), expression);
+    }
+};
+
+// 64 bit FNV-1a. Unlike std::hash, the result doesn't depend on the standard library.
+uint64_t hash(const char *data, size_t length) {
+    uint64_t result = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        result = (result ^ uint8_t(data[i])) * 1099511628211ull;
+    }
+    return result;
+}
+
+template <typename Fn>
+void eachBucket(const util::ptr<StyleLayerGroup> &group, Fn fn) {
+    if (!group) {
+        return;
+    }
+
+    for (const util::ptr<StyleLayer> &layer_desc : group->layers) {
+        if (layer_desc->layers) {
+            eachBucket(layer_desc->layers, fn);
+        }
+        if (layer_desc->bucket) {
+            fn(*layer_desc->bucket);
+        }
+    }
+}
+
+}
+
+
 VectorTileData::VectorTileData(Tile::ID const& id_, Map &map_, const util::ptr<SourceInfo> &source_)
     : TileData(id_, map_, source_),
       depth(id.z >= source->max_zoom ? map.getMaxZoom() - id.z : 1) {
@@ -19,25 +110,45 @@ VectorTileData::~VectorTileData() {
 
 
 void VectorTileData::parse() {
+    // A resumed parse may be scheduled while the previous attempt is still finishing up.
+    std::lock_guard<std::mutex> lock(mtx);
+
     if (state != State::loaded) {
         return;
     }
 
     try {
         // Parsing creates state that is encapsulated in TileParser. While parsing,
-        // the TileParser object writes results into this objects. All other state
-        // is going to be discarded afterwards.
-        TileParser parser(data, *this, map.getStyle(), map.getGlyphAtlas(),
-                          map.getGlyphStore(), map.getSpriteAtlas(), map.getSprite());
-        parser.parse();
+        // the TileParser object writes results into this objects. We keep the parser
+        // while it waits for glyphs or the sprite so that it resumes where it stopped;
+        // all other state is going to be discarded afterwards.
+        if (!parser) {
+            // Restored buckets are skipped by the parser, so only the symbol buckets are built.
+            restoredFromCache = !cachedBuckets.empty() && restoreBuckets(cachedBuckets);
+            cachedBuckets.clear();
+
+            parser = std::make_unique<TileParser>(data, *this, map.getStyle(), map.getGlyphAtlas(),
+                                                  map.getGlyphStore(), map.getSpriteAtlas(), map.getSprite());
+        }
+        if (!parser->parse()) {
+            // We're going to be reparsed once the dependencies have loaded.
+            return;
+        }
+
+        if (store && !restoredFromCache) {
+            serializedBuckets = serializeBuckets();
+        }
     } catch (const std::exception& ex) {
 #if defined(DEBUG)
         fprintf(stderr, "[%p] exception [%d/%d/%d]... failed: %s\n", this, id.z, id.x, id.y, ex.what());
 #endif
+        parser.reset();
         cancel();
         return;
     }
 
+    parser.reset();
+
     if (state != State::obsolete) {
         state = State::parsed;
     }
@@ -63,3 +174,191 @@ bool VectorTileData::hasData(StyleLayer const& layer_desc) const {
     }
     return false;
 }
+
+size_t VectorTileData::bytes() const {
+    return TileData::bytes() +
+           fillVertexBuffer.bytes() +
+           lineVertexBuffer.bytes() +
+           iconVertexBuffer.bytes() +
+           textVertexBuffer.bytes() +
+           triangleElementsBuffer.bytes() +
+           lineElementsBuffer.bytes() +
+           pointElementsBuffer.bytes();
+}
+
+void VectorTileData::loaded(FileSource &fileSource) {
+    // Buckets are cached along with the tile in the HTTP cache. Local tiles are parsed again.
+    if (url.compare(0, 7, "file://") != 0 && url.compare(0, 10, "mbtiles://") != 0) {
+        store = fileSource.getStore();
+    }
+    if (!store) {
+        reparse();
+        return;
+    }
+
+    bucketKey = bucketCacheKey();
+
+    store->getBuckets(url, bucketKey, [](std::unique_ptr<std::string> &&serialized, void *ptr) {
+        std::unique_ptr<std::weak_ptr<TileData>> weak_tile { static_cast<std::weak_ptr<TileData> *>(ptr) };
+        util::ptr<VectorTileData> tile = std::static_pointer_cast<VectorTileData>(weak_tile->lock());
+        if (!tile || tile->state != State::loaded) {
+            return;
+        }
+
+        if (serialized) {
+            tile->cachedBuckets = std::move(*serialized);
+        }
+
+        // Schedule tile parsing in another thread
+        tile->reparse();
+    }, new std::weak_ptr<TileData>(shared_from_this()));
+}
+
+void VectorTileData::afterParse() {
+    // The buckets are serialized at the end of the last parse job, before the state changes.
+    if (state == State::parsed && !serializedBuckets.empty()) {
+        store->putBuckets(url, bucketKey, std::move(serializedBuckets));
+        serializedBuckets.clear();
+        store.reset();
+    }
+}
+
+std::string VectorTileData::bucketCacheKey() const {
+    util::BinaryWriter writer;
+    writer.write<uint32_t>(source->max_zoom);
+
+    eachBucket(map.getStyle()->layers, [&](const StyleBucket &bucket) {
+        if (bucket.render.is<StyleBucketFill>()) {
+            const StyleBucketFill &fill = bucket.render.get<StyleBucketFill>();
+            writer.write(CachedBucketType::Fill);
+            writer.write(fill.winding);
+        } else if (bucket.render.is<StyleBucketLine>()) {
+            const StyleBucketLine &line = bucket.render.get<StyleBucketLine>();
+            writer.write(CachedBucketType::Line);
+            writer.write(line.cap);
+            writer.write(line.join);
+            writer.write(line.miter_limit);
+            writer.write(line.round_limit);
+        } else {
+            return;
+        }
+
+        writer.write(bucket.name);
+        writer.write(bucket.source_layer);
+        writer.write(bucket.min_zoom);
+        writer.write(bucket.max_zoom);
+        FilterWriter::writeFilter(writer, bucket.filter);
+    });
+
+    return util::sprintf<64>("%u-%016llx-%016llx", bucketCacheVersion,
+                             (unsigned long long)hash(writer.str().data(), writer.str().size()),
+                             (unsigned long long)hash(data.data(), data.size()));
+}
+
+std::string VectorTileData::serializeBuckets() const {
+    util::BinaryWriter writer;
+
+    writer.write(fillVertexBuffer.data(), fillVertexBuffer.bytes());
+    writer.write(lineVertexBuffer.data(), lineVertexBuffer.bytes());
+    writer.write(triangleElementsBuffer.data(), triangleElementsBuffer.bytes());
+    writer.write(lineElementsBuffer.data(), lineElementsBuffer.bytes());
+    writer.write(pointElementsBuffer.data(), pointElementsBuffer.bytes());
+
+    std::set<std::string> written;
+    util::BinaryWriter bucketWriter;
+    eachBucket(map.getStyle()->layers, [&](const StyleBucket &bucket_desc) {
+        auto bucket_it = buckets.find(bucket_desc.name);
+        if (bucket_it == buckets.end() || !written.insert(bucket_desc.name).second) {
+            return;
+        }
+
+        if (bucket_desc.render.is<StyleBucketFill>()) {
+            bucketWriter.write(CachedBucketType::Fill);
+            bucketWriter.write(bucket_desc.name);
+            static_cast<const FillBucket &>(*bucket_it->second).serialize(bucketWriter);
+        } else if (bucket_desc.render.is<StyleBucketLine>()) {
+            bucketWriter.write(CachedBucketType::Line);
+            bucketWriter.write(bucket_desc.name);
+            static_cast<const LineBucket &>(*bucket_it->second).serialize(bucketWriter);
+        }
+    });
+
+    writer.write(bucketWriter.str());
+    return writer.release();
+}
+
+bool VectorTileData::restoreBuckets(const std::string &serialized) {
+    if (!buckets.empty() || !fillVertexBuffer.empty() || !lineVertexBuffer.empty() ||
+        !triangleElementsBuffer.empty() || !lineElementsBuffer.empty() || !pointElementsBuffer.empty()) {
+        return false;
+    }
+
+    std::unordered_map<std::string, const StyleBucket *> descs;
+    eachBucket(map.getStyle()->layers, [&](const StyleBucket &bucket_desc) {
+        descs.emplace(bucket_desc.name, &bucket_desc);
+    });
+
+    // Read everything before touching the buffers so that a broken entry leaves the tile intact.
+    std::unordered_map<std::string, std::unique_ptr<Bucket>> restored;
+    const char *fillVertices, *lineVertices, *triangleElements, *lineElements, *pointElements;
+    size_t fillVerticesLength, lineVerticesLength, triangleElementsLength, lineElementsLength, pointElementsLength;
+
+    try {
+        util::BinaryReader reader(serialized);
+        fillVertices = reader.read(fillVerticesLength);
+        lineVertices = reader.read(lineVerticesLength);
+        triangleElements = reader.read(triangleElementsLength);
+        lineElements = reader.read(lineElementsLength);
+        pointElements = reader.read(pointElementsLength);
+
+        if (fillVerticesLength % FillVertexBuffer::itemSize != 0 ||
+            lineVerticesLength % LineVertexBuffer::itemSize != 0 ||
+            triangleElementsLength % TriangleElementsBuffer::itemSize != 0 ||
+            lineElementsLength % LineElementsBuffer::itemSize != 0 ||
+            pointElementsLength % PointElementsBuffer::itemSize != 0) {
+            throw std::runtime_error("partial elements");
+        }
+
+        const std::string bucketData = reader.readString();
+        util::BinaryReader bucketReader(bucketData);
+        while (!bucketReader.done()) {
+            const CachedBucketType type = bucketReader.read<CachedBucketType>();
+            const std::string name = bucketReader.readString();
+
+            auto desc_it = descs.find(name);
+            if (desc_it == descs.end()) {
+                throw std::runtime_error("unknown bucket " + name);
+            }
+            const StyleBucket &bucket_desc = *desc_it->second;
+
+            if (type == CachedBucketType::Fill && bucket_desc.render.is<StyleBucketFill>()) {
+                restored[name] = std::make_unique<FillBucket>(fillVertexBuffer, triangleElementsBuffer,
+                    lineElementsBuffer, bucket_desc.render.get<StyleBucketFill>(), bucketReader);
+            } else if (type == CachedBucketType::Line && bucket_desc.render.is<StyleBucketLine>()) {
+                restored[name] = std::make_unique<LineBucket>(lineVertexBuffer, triangleElementsBuffer,
+                    pointElementsBuffer, bucket_desc.render.get<StyleBucketLine>(), bucketReader);
+            } else {
+                throw std::runtime_error("bucket type mismatch for " + name);
+            }
+        }
+
+        if (!reader.done()) {
+            throw std::runtime_error("trailing data");
+        }
+    } catch (const std::exception& ex) {
+        Log::Warning(Event::ParseTile, "ignoring cached buckets of %s: %s", toString().c_str(), ex.what());
+        return false;
+    }
+
+    fillVertexBuffer.append(fillVertices, fillVerticesLength);
+    lineVertexBuffer.append(lineVertices, lineVerticesLength);
+    triangleElementsBuffer.append(triangleElements, triangleElementsLength);
+    lineElementsBuffer.append(lineElements, lineElementsLength);
+    pointElementsBuffer.append(pointElements, pointElementsLength);
+
+    for (auto &pair : restored) {
+        buckets[pair.first] = std::move(pair.second);
+    }
+
+    return true;
+}
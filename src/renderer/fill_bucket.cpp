@@ -53,6 +53,52 @@ FillBucket::FillBucket(FillVertexBuffer &vertexBuffer_,
     assert(tesselator);
 }
 
+FillBucket::FillBucket(FillVertexBuffer &vertexBuffer_,
+                       TriangleElementsBuffer &triangleElementsBuffer_,
+                       LineElementsBuffer &lineElementsBuffer_,
+                       const StyleBucketFill &properties_,
+                       util::BinaryReader &reader)
+    : properties(properties_),
+      allocator(nullptr),
+      tesselator(nullptr),
+      vertexBuffer(vertexBuffer_),
+      triangleElementsBuffer(triangleElementsBuffer_),
+      lineElementsBuffer(lineElementsBuffer_),
+      vertex_start(reader.read<uint64_t>()),
+      triangle_elements_start(reader.read<uint64_t>()),
+      line_elements_start(reader.read<uint64_t>()),
+      triangleGroups(readElementGroups<2>(reader)),
+      lineGroups(readElementGroups<1>(reader)) {
+}
+
+FillBucket::FillBucket(FillVertexBuffer &vertexBuffer_,
+                       TriangleElementsBuffer &triangleElementsBuffer_,
+                       LineElementsBuffer &lineElementsBuffer_,
+                       FillBucket &&other)
+    : properties(other.properties),
+      allocator(nullptr),
+      tesselator(nullptr),
+      vertexBuffer(vertexBuffer_),
+      triangleElementsBuffer(triangleElementsBuffer_),
+      lineElementsBuffer(lineElementsBuffer_),
+      vertex_start(vertexBuffer_.index()),
+      triangle_elements_start(triangleElementsBuffer_.index()),
+      line_elements_start(lineElementsBuffer_.index()),
+      triangleGroups(std::move(other.triangleGroups)),
+      lineGroups(std::move(other.lineGroups)) {
+    vertexBuffer.append(other.vertexBuffer, other.vertex_start);
+    triangleElementsBuffer.append(other.triangleElementsBuffer, other.triangle_elements_start);
+    lineElementsBuffer.append(other.lineElementsBuffer, other.line_elements_start);
+}
+
+void FillBucket::serialize(util::BinaryWriter &writer) const {
+    writer.write<uint64_t>(vertex_start);
+    writer.write<uint64_t>(triangle_elements_start);
+    writer.write<uint64_t>(line_elements_start);
+    writeElementGroups(writer, triangleGroups);
+    writeElementGroups(writer, lineGroups);
+}
+
 FillBucket::~FillBucket() {
     if (tesselator) {
         tessDeleteTess(tesselator);
@@ -68,18 +114,26 @@ void FillBucket::addGeometry(pbf& geom) {
     Coordinate coord;
     Geometry geometry(geom);
     int32_t x, y;
+    size_t rings = 0;
     while ((cmd = geometry.next(x, y)) != Geometry::end) {
         if (cmd == Geometry::move_to) {
             if (line.size()) {
                 clipper.AddPath(line, ClipperLib::ptSubject, true);
                 line.clear();
                 hasVertices = true;
+                rings++;
             }
         }
         line.emplace_back(x, y);
     }
 
     if (line.size()) {
+        // Most features are a single simple ring, which we can triangulate directly.
+        if (rings == 0 && addSimplePolygon()) {
+            line.clear();
+            return;
+        }
+
         clipper.AddPath(line, ClipperLib::ptSubject, true);
         line.clear();
         hasVertices = true;
@@ -88,6 +142,56 @@ void FillBucket::addGeometry(pbf& geom) {
     tessellate();
 }
 
+bool FillBucket::addSimplePolygon() {
+    if (!earcut.triangulate(line)) {
+        return false;
+    }
+
+    const std::vector<ClipperLib::IntPoint>& vertices = earcut.vertices();
+    const std::vector<uint16_t>& indices = earcut.indices();
+    const size_t vertex_count = vertices.size();
+    if (!vertex_count) {
+        return true;
+    }
+
+    if (!lineGroups.size() || (lineGroups.back().vertex_length + vertex_count > 65535)) {
+        // Move to a new group because the old one can't hold the geometry.
+        lineGroups.emplace_back();
+    }
+
+    line_group_type& lineGroup = lineGroups.back();
+    const uint32_t lineIndex = lineGroup.vertex_length;
+
+    for (const ClipperLib::IntPoint& pt : vertices) {
+        vertexBuffer.add(pt.X, pt.Y);
+    }
+
+    for (size_t i = 0; i < vertex_count; i++) {
+        const size_t prev_i = (i == 0 ? vertex_count : i) - 1;
+        lineElementsBuffer.add(lineIndex + prev_i, lineIndex + i);
+    }
+
+    lineGroup.vertex_length += vertex_count;
+    lineGroup.elements_length += vertex_count;
+
+    if (!triangleGroups.size() || (triangleGroups.back().vertex_length + vertex_count > 65535)) {
+        // Move to a new group because the old one can't hold the geometry.
+        triangleGroups.emplace_back();
+    }
+
+    triangle_group_type& triangleGroup = triangleGroups.back();
+    const uint32_t triangleIndex = triangleGroup.vertex_length;
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        triangleElementsBuffer.add(triangleIndex + indices[i], triangleIndex + indices[i + 1], triangleIndex + indices[i + 2]);
+    }
+
+    triangleGroup.vertex_length += vertex_count;
+    triangleGroup.elements_length += indices.size() / 3;
+
+    return true;
+}
+
 void FillBucket::tessellate() {
     if (!hasVertices) {
         return;
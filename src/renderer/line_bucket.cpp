@@ -31,8 +31,52 @@ LineBucket::LineBucket(LineVertexBuffer& vertexBuffer_,
 {
 }
 
+LineBucket::LineBucket(LineVertexBuffer& vertexBuffer_,
+                       TriangleElementsBuffer& triangleElementsBuffer_,
+                       PointElementsBuffer& pointElementsBuffer_,
+                       const StyleBucketLine& properties_,
+                       util::BinaryReader& reader)
+    : properties(properties_),
+      vertexBuffer(vertexBuffer_),
+      triangleElementsBuffer(triangleElementsBuffer_),
+      pointElementsBuffer(pointElementsBuffer_),
+      vertex_start(reader.read<uint64_t>()),
+      triangle_elements_start(reader.read<uint64_t>()),
+      point_elements_start(reader.read<uint64_t>()),
+      triangleGroups(readElementGroups<2>(reader)),
+      pointGroups(readElementGroups<1>(reader))
+{
+}
+
+LineBucket::LineBucket(LineVertexBuffer& vertexBuffer_,
+                       TriangleElementsBuffer& triangleElementsBuffer_,
+                       PointElementsBuffer& pointElementsBuffer_,
+                       LineBucket&& other)
+    : properties(other.properties),
+      vertexBuffer(vertexBuffer_),
+      triangleElementsBuffer(triangleElementsBuffer_),
+      pointElementsBuffer(pointElementsBuffer_),
+      vertex_start(vertexBuffer_.index()),
+      triangle_elements_start(triangleElementsBuffer_.index()),
+      point_elements_start(pointElementsBuffer_.index()),
+      triangleGroups(std::move(other.triangleGroups)),
+      pointGroups(std::move(other.pointGroups))
+{
+    vertexBuffer.append(other.vertexBuffer, other.vertex_start);
+    triangleElementsBuffer.append(other.triangleElementsBuffer, other.triangle_elements_start);
+    pointElementsBuffer.append(other.pointElementsBuffer, other.point_elements_start);
+}
+
+void LineBucket::serialize(util::BinaryWriter& writer) const {
+    writer.write<uint64_t>(vertex_start);
+    writer.write<uint64_t>(triangle_elements_start);
+    writer.write<uint64_t>(point_elements_start);
+    writeElementGroups(writer, triangleGroups);
+    writeElementGroups(writer, pointGroups);
+}
+
 void LineBucket::addGeometry(pbf& geom) {
-    std::vector<Coordinate> line;
+    decodedLine.clear();
     Geometry::command cmd;
 
     Coordinate coord;
@@ -40,15 +84,15 @@ void LineBucket::addGeometry(pbf& geom) {
     int32_t x, y;
     while ((cmd = geometry.next(x, y)) != Geometry::end) {
         if (cmd == Geometry::move_to) {
-            if (!line.empty()) {
-                addGeometry(line);
-                line.clear();
+            if (!decodedLine.empty()) {
+                addGeometry(decodedLine);
+                decodedLine.clear();
             }
         }
-        line.emplace_back(x, y);
+        decodedLine.emplace_back(x, y);
     }
-    if (line.size()) {
-        addGeometry(line);
+    if (decodedLine.size()) {
+        addGeometry(decodedLine);
     }
 }
 
@@ -199,7 +199,7 @@ void Painter::renderSymbol(SymbolBucket &bucket, util::ptr<StyleLayer> layer_des
                   bucket.properties.text,
                   properties.text,
                   24.0f,
-                  {{ float(glyphAtlas.width) / 4, float(glyphAtlas.height) / 4 }},
+                  {{ float(glyphAtlas.width), float(glyphAtlas.getTextureHeight()) }},
                   *sdfGlyphShader,
                   &SymbolBucket::drawGlyphs);
     }
@@ -41,8 +41,7 @@ void SymbolBucket::addGlyphsToAtlas(uint64_t tileid, const std::string stackname
 
 std::vector<SymbolFeature> SymbolBucket::processFeatures(const VectorTileLayer &layer,
                                                          const FilterExpression &filter,
-                                                         GlyphStore &glyphStore,
-                                                         const Sprite &sprite) {
+                                                         std::set<GlyphRange> &ranges) {
     const bool has_text = properties.text.field.size();
     const bool has_icon = properties.icon.image.size();
 
@@ -52,12 +51,10 @@ std::vector<SymbolFeature> SymbolBucket::processFeatures(const VectorTileLayer &
         return features;
     }
 
-    // Determine and load glyph ranges
-    std::set<GlyphRange> ranges;
-
+    // Determine the glyph ranges
     FilteredVectorTileLayer filtered_layer(layer, filter);
-    for (const pbf &feature_pbf : filtered_layer) {
-        const VectorTileFeature feature{feature_pbf, layer};
+    for (uint32_t index : filtered_layer) {
+        const VectorTileFeature feature{layer, index};
 
         SymbolFeature ft;
 
@@ -90,17 +87,25 @@ std::vector<SymbolFeature> SymbolBucket::processFeatures(const VectorTileLayer &
         }
     }
 
-    glyphStore.waitForGlyphRanges(properties.text.font, ranges);
-    sprite.waitUntilLoaded();
-
     return features;
 }
 
-void SymbolBucket::addFeatures(const VectorTileLayer &layer, const FilterExpression &filter,
+bool SymbolBucket::addFeatures(const VectorTileLayer &layer, const FilterExpression &filter,
                                const Tile::ID &id, SpriteAtlas &spriteAtlas, Sprite &sprite,
-                               GlyphAtlas & glyphAtlas, GlyphStore &glyphStore) {
+                               GlyphAtlas & glyphAtlas, GlyphStore &glyphStore,
+                               const std::function<void()> &callback) {
+
+    std::set<GlyphRange> ranges;
+    const std::vector<SymbolFeature> features = processFeatures(layer, filter, ranges);
 
-    const std::vector<SymbolFeature> features = processFeatures(layer, filter, glyphStore, sprite);
+    // Don't block the worker thread while glyphs or the sprite are still loading. The callback
+    // is invoked once they finished loading so that the caller can retry.
+    if (!glyphStore.hasGlyphRanges(properties.text.font, ranges, callback)) {
+        return false;
+    }
+    if (properties.icon.image.size() && !sprite.isLoaded(callback)) {
+        return false;
+    }
 
     float horizontalAlign = 0.5;
     float verticalAlign = 0.5;
@@ -171,7 +176,6 @@ void SymbolBucket::addFeatures(const VectorTileLayer &layer, const FilterExpress
 
         // if feature has icon, get sprite atlas position
         if (feature.sprite.length()) {
-            sprite.waitUntilLoaded();
             image = spriteAtlas.getImage(feature.sprite);
 
             if (sprite.getSpritePosition(feature.sprite).sdf) {
@@ -184,12 +188,14 @@ void SymbolBucket::addFeatures(const VectorTileLayer &layer, const FilterExpress
             addFeature(feature.geometry, shaping, face, image);
         }
     }
+
+    return true;
 }
 
 void SymbolBucket::addFeature(const pbf &geom_pbf, const Shaping &shaping,
                               const GlyphPositions &face, const Rect<uint16_t> &image) {
     // Decode all lines.
-    std::vector<Coordinate> line;
+    decodedLine.clear();
     Geometry::command cmd;
 
     Coordinate coord;
@@ -198,15 +204,15 @@ void SymbolBucket::addFeature(const pbf &geom_pbf, const Shaping &shaping,
     int32_t x, y;
     while ((cmd = geometry.next(x, y)) != Geometry::end) {
         if (cmd == Geometry::move_to) {
-            if (!line.empty()) {
-                addFeature(line, shaping, face, image);
-                line.clear();
+            if (!decodedLine.empty()) {
+                addFeature(decodedLine, shaping, face, image);
+                decodedLine.clear();
             }
         }
-        line.emplace_back(x, y);
+        decodedLine.emplace_back(x, y);
     }
-    if (line.size()) {
-        addFeature(line, shaping, face, image);
+    if (decodedLine.size()) {
+        addFeature(decodedLine, shaping, face, image);
     }
 }
 
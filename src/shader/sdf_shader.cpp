@@ -29,7 +29,7 @@ SDFShader::SDFShader()
 }
 
 void SDFGlyphShader::bind(char *offset) {
-    const int stride = 16;
+    const int stride = 20;
 
     glEnableVertexAttribArray(a_pos);
     glVertexAttribPointer(a_pos, 2, GL_SHORT, false, stride, offset + 0);
@@ -56,7 +56,7 @@ void SDFGlyphShader::bind(char *offset) {
     glVertexAttribPointer(a_rangestart, 1, GL_UNSIGNED_BYTE, false, stride, offset + 13);
 
     glEnableVertexAttribArray(a_tex);
-    glVertexAttribPointer(a_tex, 2, GL_UNSIGNED_BYTE, false, stride, offset + 14);
+    glVertexAttribPointer(a_tex, 2, GL_SHORT, false, stride, offset + 16);
 }
 
 void SDFIconShader::bind(char *offset) {
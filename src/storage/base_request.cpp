@@ -4,7 +4,9 @@
 
 #include <uv.h>
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 namespace mbgl {
 
@@ -32,6 +34,10 @@ void BaseRequest::retryImmediately() {
     // no-op. override in child class.
 }
 
+void BaseRequest::setPriority(double) {
+    // no-op. override in child class.
+}
+
 void BaseRequest::notify() {
     assert(thread_id == uv_thread_self());
 
@@ -43,6 +49,14 @@ void BaseRequest::notify() {
     // on the request object, which would modify the list.
     const std::forward_list<std::unique_ptr<Callback>> list = std::move(callbacks);
     callbacks.clear();
+    preliminaryCallbacks.clear();
+    preliminary.reset();
+
+    if (response && observer) {
+        const CompletedCallback fn = std::move(observer);
+        observer = nullptr;
+        fn(*response);
+    }
 
     if (response) {
         invoke<CompletedCallback>(list, *response);
@@ -53,12 +67,38 @@ void BaseRequest::notify() {
     self.reset();
 }
 
+void BaseRequest::notifyPreliminary(std::unique_ptr<Response> &&res) {
+    assert(thread_id == uv_thread_self());
+    assert(!response);
+
+    util::ptr<BaseRequest> retain = self;
+
+    preliminary = std::move(res);
+
+    // The callbacks stay registered, but they may remove themselves or others while we're
+    // iterating, so only call the ones that are still in the list.
+    std::vector<Callback *> list;
+    for (const std::unique_ptr<Callback> &callback : preliminaryCallbacks) {
+        list.push_back(callback.get());
+    }
+
+    for (Callback *callback : list) {
+        auto it = std::find_if(preliminaryCallbacks.begin(), preliminaryCallbacks.end(),
+                               [=](const std::unique_ptr<Callback> &cb) { return cb.get() == callback; });
+        if (it != preliminaryCallbacks.end() && preliminary) {
+            callback->get<CompletedCallback>()(*preliminary);
+        }
+    }
+}
+
 Callback *BaseRequest::add(Callback &&callback, const util::ptr<BaseRequest> &request) {
     assert(thread_id == uv_thread_self());
     assert(this == request.get());
 
     if (response) {
-        // We already have a response. Notify right away.
+        // We already have a response. Notify right away. The callback may destroy the Request
+        // that holds the last reference to this object, and with it the response.
+        util::ptr<BaseRequest> retain = request;
         if (callback.is<CompletedCallback>()) {
             callback.get<CompletedCallback>()(*response);
         } else {
@@ -73,12 +113,28 @@ Callback *BaseRequest::add(Callback &&callback, const util::ptr<BaseRequest> &re
     }
 }
 
+Callback *BaseRequest::addPreliminary(CompletedCallback &&callback, const util::ptr<BaseRequest> &request) {
+    assert(thread_id == uv_thread_self());
+    assert(this == request.get());
+
+    if (response) {
+        // The final response was already delivered through add().
+        return nullptr;
+    }
+
+    self = request;
+    preliminaryCallbacks.push_front(std::unique_ptr<Callback>(new Callback(std::move(callback))));
+    return preliminaryCallbacks.front().get();
+}
+
 void BaseRequest::remove(Callback *callback) {
     assert(thread_id == uv_thread_self());
-    callbacks.remove_if([=](const std::unique_ptr<Callback> &cb) {
+    auto matches = [=](const std::unique_ptr<Callback> &cb) {
         return cb.get() == callback;
-    });
-    if (callbacks.empty()) {
+    };
+    callbacks.remove_if(matches);
+    preliminaryCallbacks.remove_if(matches);
+    if (callbacks.empty() && preliminaryCallbacks.empty()) {
         self.reset();
     }
 }
@@ -2,6 +2,8 @@
 #include <mbgl/storage/file_request.hpp>
 #include <mbgl/storage/response.hpp>
 
+#include <sys/mman.h>
+
 #include <limits>
 
 namespace mbgl {
@@ -82,7 +84,11 @@ void FileRequestBaton::file_stated(uv_fs_t *req) {
 #else
         const uv_stat_t *stat = static_cast<const uv_stat_t *>(req->ptr);
 #endif
-        if (stat->st_size > std::numeric_limits<int>::max()) {
+        if (stat->st_size > 0 && map_file(req, size_t(stat->st_size))) {
+            // The file is memory-mapped and its contents are owned by the response now.
+            uv_fs_req_cleanup(req);
+            uv_fs_close(req->loop, req, ptr->fd, file_closed);
+        } else if (stat->st_size > std::numeric_limits<int>::max()) {
             // File is too large for us to open this way because uv_buf's only support unsigned
             // ints as maximum size.
             if (ptr->request) {
@@ -112,6 +118,32 @@ void FileRequestBaton::file_stated(uv_fs_t *req) {
     }
 }
 
+bool FileRequestBaton::map_file(uv_fs_t *req, size_t size) {
+    FileRequestBaton *ptr = (FileRequestBaton *)req->data;
+    assert(ptr->thread_id == uv_thread_self());
+
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, ptr->fd, 0);
+    if (addr == MAP_FAILED) {
+        // Fall back to reading the file.
+        return false;
+    }
+
+    // The mapping stays valid after closing the file and is released with the last copy of
+    // the response data.
+    std::shared_ptr<const char> bytes(static_cast<const char *>(addr), [size](const char *data) {
+        munmap(const_cast<char *>(data), size);
+    });
+
+    if (ptr->request) {
+        ptr->request->response = std::unique_ptr<Response>(new Response);
+        ptr->request->response->code = 200;
+        ptr->request->response->data = util::Blob(std::move(bytes), size);
+        ptr->request->notify();
+    }
+
+    return true;
+}
+
 void FileRequestBaton::file_read(uv_fs_t *req) {
     FileRequestBaton *ptr = (FileRequestBaton *)req->data;
     assert(ptr->thread_id == uv_thread_self());
@@ -1,6 +1,12 @@
 #include <mbgl/storage/file_source.hpp>
 #include <mbgl/storage/file_request.hpp>
 #include <mbgl/storage/http_request.hpp>
+#include <mbgl/storage/mbtiles_request.hpp>
+#include <mbgl/storage/mbtiles_store.hpp>
+#include <mbgl/storage/replay_request.hpp>
+#include <mbgl/storage/resource_archive.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/storage/response_cache.hpp>
 #include <mbgl/storage/sqlite_store.hpp>
 #include <mbgl/util/uv-messenger.h>
 
@@ -8,9 +14,62 @@
 
 namespace mbgl {
 
+namespace {
+
+// Default size of the in-memory cache. Holds a few dozen tiles and the glyph ranges and sprite
+// metadata of a typical style.
+const size_t defaultMemoryCacheSize = 8 * 1024 * 1024;
+
+// A request that was answered from the in-memory cache. The response is delivered in the next
+// loop iteration, like that of any other request, so that callbacks may drop the request.
+class MemoryRequest : public BaseRequest {
+public:
+    MemoryRequest(const std::string &path_, uv_loop_t *loop, std::unique_ptr<Response> &&response_)
+        : BaseRequest(path_), pending(std::move(response_)) {
+        timer = new uv_timer_t();
+        uv_timer_init(loop, timer);
+        timer->data = this;
+
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
+        uv_timer_start(timer, [](uv_timer_t *handle, int) {
+#else
+        uv_timer_start(timer, [](uv_timer_t *handle) {
+#endif
+            MemoryRequest *request = static_cast<MemoryRequest *>(handle->data);
+            uv_timer_stop(handle);
+            uv_close((uv_handle_t *)handle, [](uv_handle_t *h) { delete (uv_timer_t *)h; });
+            request->timer = nullptr;
+            request->response = std::move(request->pending);
+            request->notify();
+            // Note: after calling notify(), the request object may cease to exist.
+        }, 0, 0);
+    }
+
+    ~MemoryRequest() {
+        cancel();
+    }
+
+    void cancel() {
+        if (timer) {
+            uv_timer_stop(timer);
+            uv_close((uv_handle_t *)timer, [](uv_handle_t *handle) { delete (uv_timer_t *)handle; });
+            timer = nullptr;
+        }
+
+        notify();
+    }
+
+private:
+    std::unique_ptr<Response> pending;
+    uv_timer_t *timer = nullptr;
+};
+
+}
+
 FileSource::FileSource(uv_loop_t *loop_, const std::string &path)
     : thread_id(uv_thread_self()),
       store(!path.empty() ? util::ptr<SQLiteStore>(new SQLiteStore(loop_, path)) : nullptr),
+      memory(std::make_shared<ResponseCache>(defaultMemoryCacheSize)),
       loop(loop_),
       queue(new uv_messenger_t) {
 
@@ -37,6 +96,23 @@ FileSource::~FileSource() {
     }
 }
 
+void FileSource::setMaximumCacheSize(uint64_t bytes) {
+    assert(thread_id == uv_thread_self());
+    if (store) {
+        store->setMaximumSize(bytes);
+    }
+}
+
+void FileSource::setMaximumMemoryCacheSize(size_t bytes) {
+    assert(thread_id == uv_thread_self());
+    memory->setMaxBytes(bytes);
+}
+
+void FileSource::setArchive(util::ptr<ResourceArchive> archive_) {
+    assert(thread_id == uv_thread_self());
+    archive = archive_;
+}
+
 void FileSource::setBase(const std::string &value) {
     // assert(thread_id == uv_thread_self());
     base = value;
@@ -70,18 +146,65 @@ std::unique_ptr<Request> FileSource::request(ResourceType type, const std::strin
     }
 
     if (!req) {
-        if (absoluteURL.substr(0, 7) == "file://") {
+        if (archive && archive->getMode() == ResourceArchive::Mode::Replay) {
+            req = std::make_shared<ReplayRequest>(absoluteURL, loop, *archive);
+        } else if (absoluteURL.substr(0, 7) == "file://") {
             req = std::make_shared<FileRequest>(absoluteURL.substr(7), loop);
+        } else if (absoluteURL.substr(0, 10) == "mbtiles://") {
+            req = requestMBTiles(absoluteURL);
         } else {
-            req = std::make_shared<HTTPRequest>(type, absoluteURL, loop, store);
+            std::unique_ptr<Response> cached = memory->get(absoluteURL);
+            if (cached) {
+                req = std::make_shared<MemoryRequest>(absoluteURL, loop, std::move(cached));
+            } else {
+                req = std::make_shared<HTTPRequest>(type, absoluteURL, loop, store, memory);
+            }
         }
 
-        pending.emplace(absoluteURL, req);
+        if (archive && archive->getMode() == ResourceArchive::Mode::Record) {
+            record(absoluteURL, req);
+        }
+
+        pending[absoluteURL] = req;
     }
 
     return std::unique_ptr<Request>(new Request(req));
 }
 
+void FileSource::record(const std::string &url, const util::ptr<BaseRequest> &req) {
+    const timestamp requested = util::now();
+    util::ptr<ResourceArchive> recorder = archive;
+    req->observer = [recorder, url, requested](const Response &res) {
+        recorder->add(url, res, requested);
+    };
+}
+
+util::ptr<BaseRequest> FileSource::requestMBTiles(const std::string &url) {
+    // Splits mbtiles://path/to/file.mbtiles/z/x/y.ext into the path of the file and the tile.
+    // Without a tile, the TileJSON of the file is requested.
+    const std::string extension = ".mbtiles";
+    const size_t start = 10;
+    size_t end = url.find(extension, start);
+    while (end != std::string::npos) {
+        end += extension.size();
+        if (end == url.size() || url[end] == '/') {
+            break;
+        }
+        end = url.find(extension, end);
+    }
+    if (end == std::string::npos) {
+        end = url.size();
+    }
+
+    const std::string path = url.substr(start, end - start);
+    util::ptr<MBTilesStore> &file = mbtiles[path];
+    if (!file) {
+        file = std::make_shared<MBTilesStore>(loop, path);
+    }
+
+    return std::make_shared<MBTilesRequest>(url, url.substr(end), file);
+}
+
 void FileSource::prepare(std::function<void()> fn) {
     if (thread_id == uv_thread_self()) {
         fn();
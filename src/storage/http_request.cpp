@@ -1,6 +1,8 @@
 #include <mbgl/storage/http_request.hpp>
 #include <mbgl/storage/sqlite_store.hpp>
+#include <mbgl/storage/response_cache.hpp>
 #include <mbgl/storage/http_request_baton.hpp>
+#include <mbgl/util/std.hpp>
 
 #include <uv.h>
 
@@ -20,8 +22,9 @@ struct CacheRequestBaton {
     util::ptr<SQLiteStore> store;
 };
 
-HTTPRequest::HTTPRequest(ResourceType type_, const std::string &path_, uv_loop_t *loop_, util::ptr<SQLiteStore> store_)
-    : BaseRequest(path_), thread_id(uv_thread_self()), loop(loop_), store(store_), type(type_) {
+HTTPRequest::HTTPRequest(ResourceType type_, const std::string &path_, uv_loop_t *loop_, util::ptr<SQLiteStore> store_,
+                         util::ptr<ResponseCache> memory_)
+    : BaseRequest(path_), thread_id(uv_thread_self()), loop(loop_), store(store_), memory(memory_), type(type_) {
     if (store) {
         startCacheRequest();
     } else {
@@ -54,13 +57,22 @@ void HTTPRequest::handleCacheResponse(std::unique_ptr<Response> &&res) {
         const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
                                 std::chrono::system_clock::now().time_since_epoch()).count();
         if (res->expires > now) {
+            if (memory) {
+                memory->add(path, *res);
+            }
             response = std::move(res);
             notify();
             // Note: after calling notify(), the request object may cease to exist.
             // This HTTPRequest is completed.
             return;
         } else {
-            // TODO: notify with preliminary results.
+            // Show the expired entry while we're revalidating it. The conditional request is
+            // started first because the request object may cease to exist after notifying.
+            std::unique_ptr<Response> stale = std::make_unique<Response>(*res);
+            stale->stale = true;
+            startHTTPRequest(std::move(res));
+            notifyPreliminary(std::move(stale));
+            return;
         }
     }
 
@@ -75,6 +87,7 @@ void HTTPRequest::startHTTPRequest(std::unique_ptr<Response> &&res) {
     http_baton->request = this;
     http_baton->async = new uv_async_t;
     http_baton->response = std::move(res);
+    http_baton->priority = priority;
     http_baton->async->data = new util::ptr<HTTPRequestBaton>(http_baton);
 
 #if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
@@ -170,6 +183,9 @@ void HTTPRequest::handleHTTPResponse(HTTPResponseType responseType, std::unique_
             if (store) {
                 store->put(path, type, *res);
             }
+            if (memory) {
+                memory->add(path, *res);
+            }
             response = std::move(res);
             notify();
             break;
@@ -179,6 +195,9 @@ void HTTPRequest::handleHTTPResponse(HTTPResponseType responseType, std::unique_
             if (store) {
                 store->updateExpiration(path, res->expires);
             }
+            if (memory) {
+                memory->add(path, *res);
+            }
             response = std::move(res);
             notify();
             break;
@@ -260,6 +279,15 @@ void HTTPRequest::retryImmediately() {
     }
 }
 
+void HTTPRequest::setPriority(double priority_) {
+    assert(uv_thread_self() == thread_id);
+    priority = priority_;
+    if (http_baton) {
+        // Picked up by the HTTP thread the next time it starts a queued request.
+        http_baton->priority = priority;
+    }
+}
+
 void HTTPRequest::cancel() {
     assert(uv_thread_self() == thread_id);
     removeCacheBaton();
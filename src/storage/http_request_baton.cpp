@@ -3,6 +3,9 @@
 
 namespace mbgl {
 
+std::atomic<unsigned int> HTTPRequestBaton::maximumRequests { 20 };
+std::atomic<unsigned int> HTTPRequestBaton::maximumRequestsPerHost { 8 };
+
 HTTPRequestBaton::HTTPRequestBaton(const std::string &path_) : thread_id(uv_thread_self()), path(path_) {
 }
 
@@ -0,0 +1,49 @@
+#include <mbgl/storage/mbtiles_request.hpp>
+#include <mbgl/storage/mbtiles_store.hpp>
+#include <mbgl/storage/response.hpp>
+
+#include <uv.h>
+
+#include <cassert>
+
+namespace mbgl {
+
+struct MBTilesRequestBaton {
+    MBTilesRequest *request = nullptr;
+};
+
+MBTilesRequest::MBTilesRequest(const std::string &path_, const std::string &resource, util::ptr<MBTilesStore> store_)
+    : BaseRequest(path_), baton(new MBTilesRequestBaton), store(store_) {
+    baton->request = this;
+    store->get(resource, [](std::unique_ptr<Response> &&res, void *ptr) {
+        // Wrap in a unique_ptr, so it'll always get auto-destructed.
+        std::unique_ptr<MBTilesRequestBaton> request_baton((MBTilesRequestBaton *)ptr);
+        if (request_baton->request) {
+            MBTilesRequest *request = request_baton->request;
+            request->baton = nullptr;
+            request->response = std::move(res);
+            request->notify();
+            // Note: after calling notify(), the request object may cease to exist.
+        }
+    }, baton);
+}
+
+void MBTilesRequest::cancel() {
+    assert(thread_id == uv_thread_self());
+
+    if (baton) {
+        // The lookup can't be interrupted, but its result is discarded. The baton is deleted
+        // by the callback.
+        baton->request = nullptr;
+        baton = nullptr;
+    }
+
+    notify();
+}
+
+MBTilesRequest::~MBTilesRequest() {
+    assert(thread_id == uv_thread_self());
+    cancel();
+}
+
+}
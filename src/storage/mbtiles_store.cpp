@@ -0,0 +1,276 @@
+#include <mbgl/storage/mbtiles_store.hpp>
+#include <mbgl/util/compression.hpp>
+#include <mbgl/util/sqlite3.hpp>
+
+#include <mbgl/util/uv-worker.h>
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <uv.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace mapbox::sqlite;
+
+namespace mbgl {
+
+namespace {
+
+// Upper bound for the number of reader threads and connections.
+const unsigned int maxReaders = 4;
+
+typedef rapidjson::Writer<rapidjson::StringBuffer> JSONWriter;
+
+std::unique_ptr<Response> errorResponse(long code, const std::string &message) {
+    std::unique_ptr<Response> response { new Response };
+    response->code = code;
+    response->message = message;
+    return response;
+}
+
+// Writes comma separated numbers like the bounds and center metadata as an array.
+void writeNumbers(JSONWriter &writer, const std::string &list) {
+    writer.StartArray();
+    std::istringstream stream(list);
+    std::string number;
+    while (std::getline(stream, number, ',')) {
+        writer.Double(std::strtod(number.c_str(), nullptr));
+    }
+    writer.EndArray();
+}
+
+}
+
+// Statements are compiled once per query and reused.
+struct MBTilesConnection {
+    MBTilesConnection(const std::string &path) : db(path.c_str(), ReadOnly) {}
+
+    // The query must be a string literal; statements are cached by its address.
+    Statement &prepare(const char *query) {
+        std::unique_ptr<Statement> &stmt = statements[query];
+        if (!stmt) {
+            stmt = std::unique_ptr<Statement>(new Statement(db.prepare(query)));
+        } else {
+            stmt->reset();
+        }
+        return *stmt;
+    }
+
+    Database db;
+    std::unordered_map<const char *, std::unique_ptr<Statement>> statements;
+};
+
+// Read-only connections that are opened on demand and kept for reuse.
+class MBTilesStore::ConnectionPool : private util::noncopyable {
+public:
+    ConnectionPool(const std::string &path_) : path(path_) {}
+
+    // Throws if the file can't be opened.
+    std::unique_ptr<MBTilesConnection> acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idle.empty()) {
+                std::unique_ptr<MBTilesConnection> conn = std::move(idle.back());
+                idle.pop_back();
+                return conn;
+            }
+        }
+        return std::unique_ptr<MBTilesConnection>(new MBTilesConnection(path));
+    }
+
+    void release(std::unique_ptr<MBTilesConnection> conn) {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.emplace_back(std::move(conn));
+    }
+
+private:
+    const std::string path;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<MBTilesConnection>> idle;
+};
+
+namespace {
+
+std::unique_ptr<Response> getTile(MBTilesConnection &conn, const std::string &resource) {
+    int z = 0, x = 0, y = 0;
+    if (std::sscanf(resource.c_str(), "/%d/%d/%d", &z, &x, &y) != 3 || z < 0 || z > 30 ||
+        x < 0 || x >= (1 << z) || y < 0 || y >= (1 << z)) {
+        return errorResponse(404, "invalid tile path " + resource);
+    }
+
+    //                                                   0
+    Statement &stmt = conn.prepare("SELECT `tile_data` FROM `tiles` "
+    //                                 1                     2                    3
+        "WHERE `zoom_level` = ? AND `tile_column` = ? AND `tile_row` = ?");
+    stmt.bind(1, z);
+    stmt.bind(2, x);
+    // MBTiles uses the TMS scheme, which counts rows from the bottom.
+    stmt.bind(3, (1 << z) - 1 - y);
+
+    std::unique_ptr<Response> response;
+    if (stmt.run()) {
+        response = std::unique_ptr<Response>(new Response);
+        response->code = 200;
+        size_t length = 0;
+        const char *blob = stmt.getBlob(0, length);
+        if (length >= 2 && uint8_t(blob[0]) == 0x1F && uint8_t(blob[1]) == 0x8B) {
+            // Vector tiles are stored gzip compressed. They are inflated once here and never
+            // go through the cache, which would compress them again.
+            response->data = util::decompress(blob, length);
+        } else {
+            response->data = std::string(blob, length);
+        }
+    } else {
+        response = errorResponse(404, "tile not found");
+    }
+    stmt.reset();
+    return response;
+}
+
+std::unique_ptr<Response> getTileJSON(MBTilesConnection &conn, const std::string &path) {
+    std::unordered_map<std::string, std::string> metadata;
+    Statement &stmt = conn.prepare("SELECT `name`, `value` FROM `metadata`");
+    while (stmt.run()) {
+        metadata.emplace(stmt.get<std::string>(0), stmt.get<std::string>(1));
+    }
+    stmt.reset();
+
+    // Older files don't always store the zoom range.
+    if (!metadata.count("minzoom") || !metadata.count("maxzoom")) {
+        Statement &zooms = conn.prepare("SELECT MIN(`zoom_level`), MAX(`zoom_level`) FROM `tiles`");
+        if (zooms.run()) {
+            metadata.emplace("minzoom", std::to_string(zooms.get<int>(0)));
+            metadata.emplace("maxzoom", std::to_string(zooms.get<int>(1)));
+        }
+        zooms.reset();
+    }
+
+    const std::string format = metadata.count("format") ? metadata["format"] : "pbf";
+    const std::string tiles = "mbtiles://" + path + "/{z}/{x}/{y}." + format;
+
+    rapidjson::StringBuffer buffer;
+    JSONWriter writer(buffer);
+    writer.StartObject();
+
+    writer.String("tilejson");
+    writer.String("2.0.0");
+
+    writer.String("tiles");
+    writer.StartArray();
+    writer.String(tiles.c_str(), rapidjson::SizeType(tiles.size()));
+    writer.EndArray();
+
+    for (const char *key : { "name", "description", "attribution", "version" }) {
+        auto it = metadata.find(key);
+        if (it != metadata.end()) {
+            writer.String(key);
+            writer.String(it->second.c_str(), rapidjson::SizeType(it->second.size()));
+        }
+    }
+
+    for (const char *key : { "minzoom", "maxzoom" }) {
+        auto it = metadata.find(key);
+        if (it != metadata.end()) {
+            writer.String(key);
+            writer.Int(std::atoi(it->second.c_str()));
+        }
+    }
+
+    for (const char *key : { "bounds", "center" }) {
+        auto it = metadata.find(key);
+        if (it != metadata.end()) {
+            writer.String(key);
+            writeNumbers(writer, it->second);
+        }
+    }
+
+    // Vector tilesets describe their layers in a JSON encoded metadata entry.
+    auto json = metadata.find("json");
+    rapidjson::Document document;
+    if (json != metadata.end()) {
+        document.Parse<0>(json->second.c_str());
+        if (!document.HasParseError() && document.IsObject() && document.HasMember("vector_layers")) {
+            writer.String("vector_layers");
+            document["vector_layers"].Accept(writer);
+        }
+    }
+
+    writer.EndObject();
+
+    std::unique_ptr<Response> response { new Response };
+    response->code = 200;
+    response->data = std::string(buffer.GetString(), buffer.Size());
+    return response;
+}
+
+}
+
+struct MBTilesGetBaton {
+    util::ptr<MBTilesStore::ConnectionPool> readers;
+    std::string path;
+    std::string resource;
+    void *ptr = nullptr;
+    MBTilesStore::GetCallback callback = nullptr;
+    std::unique_ptr<Response> response;
+};
+
+MBTilesStore::MBTilesStore(uv_loop_t *loop, const std::string &path_)
+    : thread_id(uv_thread_self()),
+      path(path_),
+      readers(std::make_shared<ConnectionPool>(path)) {
+    worker = new uv_worker_t;
+    uv_worker_init(worker, loop, std::max(1u, std::min(maxReaders, std::thread::hardware_concurrency())), "MBTiles");
+}
+
+MBTilesStore::~MBTilesStore() {
+    assert(uv_thread_self() == thread_id);
+    if (worker) {
+        uv_worker_close(worker, [](uv_worker_t *worker_handle) {
+            delete worker_handle;
+        });
+    }
+}
+
+void MBTilesStore::get(const std::string &resource, GetCallback callback, void *ptr) {
+    assert(uv_thread_self() == thread_id);
+
+    MBTilesGetBaton *get_baton = new MBTilesGetBaton;
+    get_baton->readers = readers;
+    get_baton->path = path;
+    get_baton->resource = resource;
+    get_baton->ptr = ptr;
+    get_baton->callback = callback;
+
+    uv_worker_send(worker, get_baton, [](void *data) {
+        MBTilesGetBaton *baton = (MBTilesGetBaton *)data;
+        try {
+            std::unique_ptr<MBTilesConnection> conn = baton->readers->acquire();
+            if (baton->resource.empty()) {
+                baton->response = getTileJSON(*conn, baton->path);
+            } else {
+                baton->response = getTile(*conn, baton->resource);
+            }
+            baton->readers->release(std::move(conn));
+        } catch (const std::exception &ex) {
+            // The file doesn't exist or isn't an MBTiles file.
+            baton->response = errorResponse(500, ex.what());
+        }
+    }, [](void *data) {
+        std::unique_ptr<MBTilesGetBaton> baton { (MBTilesGetBaton *)data };
+        if (baton->callback) {
+            baton->callback(std::move(baton->response), baton->ptr);
+        }
+    });
+}
+
+}
@@ -0,0 +1,53 @@
+#include <mbgl/storage/replay_request.hpp>
+#include <mbgl/storage/resource_archive.hpp>
+#include <mbgl/storage/response.hpp>
+
+#include <uv.h>
+
+#include <cassert>
+
+namespace mbgl {
+
+ReplayRequest::ReplayRequest(const std::string &path_, uv_loop_t *loop, const ResourceArchive &archive)
+    : BaseRequest(path_) {
+    uint64_t delay = 0;
+    pending = archive.get(path, delay);
+
+    // Even without latency, the response arrives asynchronously like that of any other request.
+    timer = new uv_timer_t();
+    uv_timer_init(loop, timer);
+    timer->data = this;
+
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
+    uv_timer_start(timer, [](uv_timer_t *handle, int) {
+#else
+    uv_timer_start(timer, [](uv_timer_t *handle) {
+#endif
+        ReplayRequest *request = static_cast<ReplayRequest *>(handle->data);
+        uv_timer_stop(handle);
+        uv_close((uv_handle_t *)handle, [](uv_handle_t *h) { delete (uv_timer_t *)h; });
+        request->timer = nullptr;
+        request->response = std::move(request->pending);
+        request->notify();
+        // Note: after calling notify(), the request object may cease to exist.
+    }, delay, 0);
+}
+
+void ReplayRequest::cancel() {
+    assert(thread_id == uv_thread_self());
+
+    if (timer) {
+        uv_timer_stop(timer);
+        uv_close((uv_handle_t *)timer, [](uv_handle_t *handle) { delete (uv_timer_t *)handle; });
+        timer = nullptr;
+    }
+
+    notify();
+}
+
+ReplayRequest::~ReplayRequest() {
+    assert(thread_id == uv_thread_self());
+    cancel();
+}
+
+}
@@ -35,6 +35,29 @@ void Request::oncancel(AbortedCallback cb) {
     }
 }
 
+void Request::onpreliminary(CompletedCallback cb) {
+    assert(thread_id == uv_thread_self());
+    if (base) {
+        // The callback may cancel this request, which resets base.
+        util::ptr<BaseRequest> retain = base;
+        Callback *callback = retain->addPreliminary(std::move(cb), retain);
+        if (callback) {
+            callbacks.push_front(callback);
+            if (retain->preliminary) {
+                // We already have a preliminary response. Notify right away.
+                callback->get<CompletedCallback>()(*retain->preliminary);
+            }
+        }
+    }
+}
+
+void Request::setPriority(double priority) {
+    assert(thread_id == uv_thread_self());
+    if (base) {
+        base->setPriority(priority);
+    }
+}
+
 void Request::cancel() {
     assert(thread_id == uv_thread_self());
     if (base) {
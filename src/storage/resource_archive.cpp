@@ -0,0 +1,143 @@
+#include <mbgl/storage/resource_archive.hpp>
+#include <mbgl/platform/log.hpp>
+#include <mbgl/util/sqlite3.hpp>
+
+#include <cassert>
+
+using namespace mapbox::sqlite;
+
+namespace mbgl {
+
+namespace {
+
+const char *const schema =
+    "CREATE TABLE IF NOT EXISTS `responses` ("
+    "    `url` TEXT PRIMARY KEY NOT NULL,"
+    "    `code` INTEGER NOT NULL,"
+    "    `modified` INTEGER,"
+    "    `expires` INTEGER,"
+    "    `etag` TEXT,"
+    "    `data` BLOB,"
+    "    `message` TEXT,"
+    "    `started` INTEGER NOT NULL," // milliseconds since the start of the recording
+    "    `latency` INTEGER NOT NULL"  // milliseconds from the request to the response
+    ");";
+
+}
+
+ResourceArchive::ResourceArchive(const std::string &path_, Mode mode_)
+    : ResourceArchive(path_, mode_, Profile()) {
+}
+
+ResourceArchive::ResourceArchive(const std::string &path_, Mode mode_, const Profile &profile_)
+    : path(path_), mode(mode_), profile(profile_), created(util::now()) {
+    if (mode != Mode::Replay) {
+        return;
+    }
+
+    Database db(path, ReadOnly);
+    Statement stmt = db.prepare("SELECT `url`, `code`, `modified`, `expires`, `etag`, `data`, "
+                                "`message`, `started`, `latency` FROM `responses`");
+    while (stmt.run()) {
+        Entry entry;
+        entry.response.code = stmt.get<int64_t>(1);
+        entry.response.modified = stmt.get<int64_t>(2);
+        entry.response.expires = stmt.get<int64_t>(3);
+        entry.response.etag = stmt.get<std::string>(4);
+        size_t length = 0;
+        const char *data = stmt.getBlob(5, length);
+        entry.response.data = std::string(data ? data : "", length);
+        entry.response.message = stmt.get<std::string>(6);
+        entry.started = stmt.get<int64_t>(7);
+        entry.latency = stmt.get<int64_t>(8);
+        entry.saved = true;
+        entries.emplace(stmt.get<std::string>(0), std::move(entry));
+    }
+}
+
+ResourceArchive::~ResourceArchive() {
+    // The archive is often released while the FileSource shuts down, where an exception would
+    // terminate the process.
+    try {
+        save();
+    } catch (const std::exception &ex) {
+        Log::Warning(Event::Database, "failed to save resource archive %s: %s", path.c_str(), ex.what());
+    }
+}
+
+void ResourceArchive::add(const std::string &url, const Response &response, timestamp requested) {
+    assert(mode == Mode::Record);
+    const timestamp now = util::now();
+
+    Entry &entry = entries[url];
+    entry.response = response;
+    entry.response.stale = false;
+    entry.started = (requested > created ? requested - created : 0) / 1_millisecond;
+    entry.latency = (now > requested ? now - requested : 0) / 1_millisecond;
+    entry.saved = false;
+}
+
+void ResourceArchive::save() {
+    if (mode != Mode::Record) {
+        return;
+    }
+
+    Database db(path, ReadWrite | Create);
+    db.exec(schema);
+    db.exec("BEGIN");
+    Statement stmt = db.prepare("REPLACE INTO `responses` (`url`, `code`, `modified`, `expires`, "
+                                "`etag`, `data`, `message`, `started`, `latency`) "
+                                "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    for (auto &pair : entries) {
+        Entry &entry = pair.second;
+        if (entry.saved) {
+            continue;
+        }
+        stmt.bind(1, pair.first.c_str());
+        stmt.bind<int64_t>(2, entry.response.code);
+        stmt.bind(3, entry.response.modified);
+        stmt.bind(4, entry.response.expires);
+        stmt.bind(5, entry.response.etag.c_str());
+        stmt.bind(6, entry.response.data.data(), entry.response.data.size(), false);
+        stmt.bind(7, entry.response.message.c_str());
+        stmt.bind<int64_t>(8, entry.started);
+        stmt.bind<int64_t>(9, entry.latency);
+        stmt.run();
+        stmt.reset();
+        entry.saved = true;
+    }
+    db.exec("COMMIT");
+}
+
+std::unique_ptr<Response> ResourceArchive::get(const std::string &url, uint64_t &delay) const {
+    std::unique_ptr<Response> response { new Response };
+
+    auto it = entries.find(url);
+    if (it == entries.end()) {
+        response->code = 404;
+        response->message = "Resource not found in archive";
+        delay = profile.latency == Latency::Simulated ? profile.delay : 0;
+        return response;
+    }
+
+    *response = it->second.response;
+
+    switch (profile.latency) {
+    case Latency::Recorded:
+        delay = it->second.latency;
+        break;
+    case Latency::None:
+        delay = 0;
+        break;
+    case Latency::Simulated:
+        delay = profile.delay;
+        if (profile.bandwidth) {
+            delay += response->data.size() * 1000 / profile.bandwidth;
+        }
+        break;
+    }
+
+    return response;
+}
+
+}
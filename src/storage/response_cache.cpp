@@ -0,0 +1,92 @@
+#include <mbgl/storage/response_cache.hpp>
+#include <mbgl/storage/response.hpp>
+
+#include <cassert>
+#include <chrono>
+
+namespace mbgl {
+
+namespace {
+
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}
+
+ResponseCache::ResponseCache(size_t maxBytes_)
+    : maxBytes(maxBytes_) {
+}
+
+void ResponseCache::setMaxBytes(size_t maxBytes_) {
+    maxBytes = maxBytes_;
+    evict();
+}
+
+void ResponseCache::add(const std::string &url, const Response &response) {
+    remove(url);
+
+    // Expired responses need to be revalidated, which the persistent cache takes care of.
+    if (response.code != 200 || response.stale || response.expires <= now()) {
+        return;
+    }
+
+    const size_t size = sizeof(Response) + url.size() + response.etag.size() + response.data.size();
+    if (size > maxBytes) {
+        return;
+    }
+
+    std::unique_ptr<Response> copy { new Response(response) };
+    copy->message.clear();
+
+    auto position = order.insert(order.end(), url);
+    entries.emplace(url, Entry { std::move(copy), size, position });
+    bytes += size;
+
+    evict();
+}
+
+std::unique_ptr<Response> ResponseCache::get(const std::string &url) {
+    auto it = entries.find(url);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+
+    if (it->second.response->expires <= now()) {
+        remove(url);
+        return nullptr;
+    }
+
+    // Mark as most recently used.
+    order.splice(order.end(), order, it->second.position);
+
+    return std::unique_ptr<Response>(new Response(*it->second.response));
+}
+
+void ResponseCache::remove(const std::string &url) {
+    auto it = entries.find(url);
+    if (it != entries.end()) {
+        bytes -= it->second.bytes;
+        order.erase(it->second.position);
+        entries.erase(it);
+    }
+}
+
+void ResponseCache::clear() {
+    order.clear();
+    entries.clear();
+    bytes = 0;
+}
+
+void ResponseCache::evict() {
+    while (bytes > maxBytes && !order.empty()) {
+        auto it = entries.find(order.front());
+        assert(it != entries.end());
+        bytes -= it->second.bytes;
+        entries.erase(it);
+        order.pop_front();
+    }
+}
+
+}
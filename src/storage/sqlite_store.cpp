@@ -4,7 +4,12 @@
 
 #include <mbgl/util/uv-worker.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 using namespace mapbox::sqlite;
 
@@ -56,15 +61,231 @@ std::string unifyMapboxURLs(const std::string &url) {
 
 namespace mbgl {
 
+namespace {
+
+// Writes are committed once this many are queued, or after the flush interval.
+const size_t maxBatchSize = 64;
+const uint64_t flushInterval = 250; // milliseconds
+
+// Bulk downloads write far more entries, so they use larger transactions.
+const size_t maxBulkBatchSize = 1024;
+const uint64_t bulkFlushInterval = 1000; // milliseconds
+
+// Upper bound for the number of reader threads and connections.
+const unsigned int maxReaders = 4;
+
+// Eviction removes entries until the cache is this much below the maximum size, so that it
+// doesn't have to run again after every write.
+const double evictionTarget = 0.9;
+
+// The size of the cache: stored responses and the buckets parsed from them.
+const char *const totalSizeQuery =
+    "SELECT (SELECT IFNULL(SUM(`size`), 0) FROM `http_cache`) + "
+    "(SELECT IFNULL(SUM(length(`data`)), 0) FROM `bucket_cache`)";
+
+int64_t currentTime() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}
+
+// Statements are compiled once per query and reused.
+struct SQLiteStore::Connection {
+    Connection(const std::string &path, int flags) : db(path.c_str(), flags) {}
+
+    // The query must be a string literal; statements are cached by its address.
+    Statement &prepare(const char *query) {
+        std::unique_ptr<Statement> &stmt = statements[query];
+        if (!stmt) {
+            stmt = std::unique_ptr<Statement>(new Statement(db.prepare(query)));
+        } else {
+            stmt->reset();
+        }
+        return *stmt;
+    }
+
+    // Deletes least recently used entries until the cache is below the maximum size.
+    void evict();
+
+    Database db;
+    std::unordered_map<const char *, std::unique_ptr<Statement>> statements;
+
+    // Only maintained for the writer connection.
+    int64_t size = 0;
+    uint64_t maximumSize = 0;
+};
+
+void SQLiteStore::Connection::evict() {
+    if (!maximumSize || size <= int64_t(maximumSize)) {
+        return;
+    }
+
+    const int64_t target = int64_t(maximumSize * evictionTarget);
+    std::vector<std::pair<std::string, int64_t>> entries;
+
+    prepare("BEGIN").run();
+
+    // Tiles are evicted first, along with the buckets parsed from them. Then the largest
+    // buckets go, including those of pinned tiles; they can be parsed again. Glyphs, sprites and
+    // JSON resources are needed for every map view, so they're only evicted once there are no
+    // tiles left.
+    for (int pass = 0; pass < 3; pass++) {
+        while (size > target) {
+            Statement &select = pass == 0
+                ? prepare("SELECT `http_cache`.`url`, `size` + IFNULL(length(`bucket_cache`.`data`), 0) "
+                          "FROM `http_cache` LEFT JOIN `bucket_cache` USING (`url`) "
+                          "WHERE `pinned` = 0 AND `type` IN (0, 1) " // Unknown, Tile
+                          "ORDER BY `accessed` LIMIT 64")
+                : pass == 1
+                ? prepare("SELECT `url`, length(`data`) FROM `bucket_cache` "
+                          "ORDER BY length(`data`) DESC LIMIT 64")
+                : prepare("SELECT `http_cache`.`url`, `size` + IFNULL(length(`bucket_cache`.`data`), 0) "
+                          "FROM `http_cache` LEFT JOIN `bucket_cache` USING (`url`) "
+                          "WHERE `pinned` = 0 ORDER BY `accessed` LIMIT 64");
+            entries.clear();
+            while (select.run()) {
+                entries.emplace_back(select.get<std::string>(0), select.get<int64_t>(1));
+            }
+            select.reset();
+
+            if (entries.empty()) {
+                break;
+            }
+
+            for (const auto &entry : entries) {
+                if (pass != 1) {
+                    Statement &remove = prepare("DELETE FROM `http_cache` WHERE `url` = ?");
+                    remove.bind(1, entry.first.c_str());
+                    remove.run();
+                }
+
+                // Buckets are useless without the tile.
+                Statement &removeBuckets = prepare("DELETE FROM `bucket_cache` WHERE `url` = ?");
+                removeBuckets.bind(1, entry.first.c_str());
+                removeBuckets.run();
+
+                size -= entry.second;
+                if (pass == 1 && size <= target) {
+                    break;
+                }
+            }
+        }
+    }
+
+    prepare("COMMIT").run();
+}
+
+// Access times of lookups that hit, by unified URL. Written to by the reader threads and
+// drained by the writer thread.
+class SQLiteStore::AccessLog : private util::noncopyable {
+public:
+    void record(const std::string &url) {
+        std::lock_guard<std::mutex> lock(mutex);
+        accessed[url] = currentTime();
+    }
+
+    std::unordered_map<std::string, int64_t> drain() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unordered_map<std::string, int64_t> result;
+        result.swap(accessed);
+        return result;
+    }
+
+    bool empty() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return accessed.empty();
+    }
+
+private:
+    std::mutex mutex;
+    std::unordered_map<std::string, int64_t> accessed;
+};
+
+// Read-only connections that are opened on demand and kept for reuse.
+class SQLiteStore::ConnectionPool : private util::noncopyable {
+public:
+    ConnectionPool(const std::string &path_) : path(path_) {}
+
+    std::unique_ptr<Connection> acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idle.empty()) {
+                std::unique_ptr<Connection> conn = std::move(idle.back());
+                idle.pop_back();
+                return conn;
+            }
+        }
+        return std::unique_ptr<Connection>(new Connection(path, ReadOnly));
+    }
+
+    void release(std::unique_ptr<Connection> conn) {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.emplace_back(std::move(conn));
+    }
+
+private:
+    const std::string path;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Connection>> idle;
+};
+
+namespace {
+
+// The connection a lookup runs on: the writer connection if there is one, otherwise a
+// connection that is borrowed from the pool for the duration of the lookup.
+class ReadConnection : private util::noncopyable {
+public:
+    ReadConnection(const util::ptr<SQLiteStore::Connection> &writer_,
+                   const util::ptr<SQLiteStore::ConnectionPool> &pool_)
+        : writer(writer_), pool(pool_) {
+        if (!writer) {
+            reader = pool->acquire();
+        }
+    }
+
+    ~ReadConnection() {
+        if (reader) {
+            pool->release(std::move(reader));
+        }
+    }
+
+    SQLiteStore::Connection &operator*() { return writer ? *writer : *reader; }
+
+private:
+    const util::ptr<SQLiteStore::Connection> writer;
+    const util::ptr<SQLiteStore::ConnectionPool> pool;
+    std::unique_ptr<SQLiteStore::Connection> reader;
+};
+
+}
+
 SQLiteStore::SQLiteStore(uv_loop_t *loop, const std::string &path)
     : thread_id(uv_thread_self()),
-      db(std::make_shared<Database>(path.c_str(), ReadWrite | Create)) {
+      connection(std::make_shared<Connection>(path, ReadWrite | Create)),
+      readers(std::make_shared<ConnectionPool>(path)),
+      accessLog(std::make_shared<AccessLog>()),
+      committingPaths(std::make_shared<std::unordered_map<std::string, unsigned int>>()) {
     createSchema();
     worker = new uv_worker_t;
     uv_worker_init(worker, loop, 1, "SQLite");
+    reader_worker = new uv_worker_t;
+    uv_worker_init(reader_worker, loop, std::max(1u, std::min(maxReaders, std::thread::hardware_concurrency())), "SQLite Reader");
+    flushTimer = new uv_timer_t;
+    uv_timer_init(loop, flushTimer);
+    flushTimer->data = this;
 }
 
 SQLiteStore::~SQLiteStore() {
+    // Queued writes are still committed before the worker thread terminates.
+    flush();
+
+    if (flushTimer) {
+        uv_close((uv_handle_t *)flushTimer, [](uv_handle_t *handle) {
+            delete (uv_timer_t *)handle;
+        });
+    }
+
     // Nothing to do. This function needs to be here because we're forward-declaring
     // Database, so we need the actual definition here to be able to properly destruct it.
     if (worker) {
@@ -72,28 +293,84 @@ SQLiteStore::~SQLiteStore() {
             delete worker_handle;
         });
     }
+    if (reader_worker) {
+        uv_worker_close(reader_worker, [](uv_worker_t *worker_handle) {
+            delete worker_handle;
+        });
+    }
 }
 
 void SQLiteStore::createSchema() {
-    if (!db || !*db) {
+    if (!connection || !connection->db) {
         return;
     }
 
-    db->exec("CREATE TABLE IF NOT EXISTS `http_cache` ("
-             "    `url` TEXT PRIMARY KEY NOT NULL,"
-             "    `code` INTEGER NOT NULL,"
-             "    `type` INTEGER NOT NULL,"
-             "    `modified` INTEGER,"
-             "    `etag` TEXT,"
-             "    `expires` INTEGER,"
-             "    `data` BLOB,"
-             "    `compressed` INTEGER NOT NULL DEFAULT 0"
-             ");"
-             "CREATE INDEX IF NOT EXISTS `http_cache_type_idx` ON `http_cache` (`type`);");
+    Database &db = connection->db;
+
+    // Readers don't wait for writers with a write-ahead log, and a cache can afford to lose the
+    // last transactions on power loss in exchange for fewer fsyncs.
+    db.exec("PRAGMA journal_mode = WAL;"
+            "PRAGMA synchronous = NORMAL;");
+
+    db.exec("CREATE TABLE IF NOT EXISTS `http_cache` ("
+            "    `url` TEXT PRIMARY KEY NOT NULL,"
+            "    `code` INTEGER NOT NULL,"
+            "    `type` INTEGER NOT NULL,"
+            "    `modified` INTEGER,"
+            "    `etag` TEXT,"
+            "    `expires` INTEGER,"
+            "    `data` BLOB,"
+            "    `compressed` INTEGER NOT NULL DEFAULT 0,"
+            "    `accessed` INTEGER NOT NULL DEFAULT 0,"
+            "    `size` INTEGER NOT NULL DEFAULT 0,"
+            "    `pinned` INTEGER NOT NULL DEFAULT 0"
+            ");"
+            "CREATE INDEX IF NOT EXISTS `http_cache_type_idx` ON `http_cache` (`type`);"
+            "CREATE TABLE IF NOT EXISTS `bucket_cache` ("
+            "    `url` TEXT PRIMARY KEY NOT NULL,"
+            "    `key` TEXT NOT NULL,"
+            "    `data` BLOB"
+            ");");
+
+    // Caches created by older versions don't track the access time and size of entries yet,
+    // and can't pin entries.
+    bool hasAccessed = false;
+    bool hasPinned = false;
+    {
+        Statement columns = db.prepare("PRAGMA table_info(`http_cache`)");
+        while (columns.run()) {
+            const std::string column = columns.get<std::string>(1);
+            if (column == "accessed") {
+                hasAccessed = true;
+            } else if (column == "pinned") {
+                hasPinned = true;
+            }
+        }
+    }
+    if (!hasAccessed) {
+        db.exec("ALTER TABLE `http_cache` ADD COLUMN `accessed` INTEGER NOT NULL DEFAULT 0;"
+                "ALTER TABLE `http_cache` ADD COLUMN `size` INTEGER NOT NULL DEFAULT 0;"
+                "UPDATE `http_cache` SET `size` = length(`data`);");
+    }
+    if (!hasPinned) {
+        db.exec("ALTER TABLE `http_cache` ADD COLUMN `pinned` INTEGER NOT NULL DEFAULT 0;");
+    }
+    db.exec("CREATE INDEX IF NOT EXISTS `http_cache_accessed_idx` ON `http_cache` (`accessed`);");
+
+    // Older versions also stored the buckets of tiles that aren't in the HTTP cache; they were
+    // never evicted.
+    db.exec("DELETE FROM `bucket_cache` WHERE `url` NOT IN (SELECT `url` FROM `http_cache`);");
+
+    Statement total = db.prepare(totalSizeQuery);
+    if (total.run()) {
+        connection->size = total.get<int64_t>(0);
+    }
 }
 
 struct GetBaton {
-    util::ptr<Database> db;
+    util::ptr<SQLiteStore::Connection> connection;
+    util::ptr<SQLiteStore::ConnectionPool> readers;
+    util::ptr<SQLiteStore::AccessLog> accessLog;
     std::string path;
     ResourceType type;
     void *ptr = nullptr;
@@ -103,24 +380,37 @@ struct GetBaton {
 
 void SQLiteStore::get(const std::string &path, GetCallback callback, void *ptr) {
     assert(uv_thread_self() == thread_id);
-    if (!db || !*db) {
+    if (!connection || !connection->db) {
         if (callback) {
             callback(nullptr, ptr);
         }
         return;
     }
 
+    // Make sure that we read our own writes.
+    if (pendingPaths.count(path)) {
+        flush();
+    }
+
     GetBaton *get_baton = new GetBaton;
-    get_baton->db = db;
+    get_baton->readers = readers;
+    get_baton->accessLog = accessLog;
     get_baton->path = path;
     get_baton->ptr = ptr;
     get_baton->callback = callback;
 
-    uv_worker_send(worker, get_baton, [](void *data) {
+    uv_worker_t *target = reader_worker;
+    if (committingPaths->count(path)) {
+        get_baton->connection = connection;
+        target = worker;
+    }
+
+    uv_worker_send(target, get_baton, [](void *data) {
         GetBaton *baton = (GetBaton *)data;
         const std::string url = unifyMapboxURLs(baton->path);
-        //                                                    0       1         2
-        Statement stmt = baton->db->prepare("SELECT `code`, `type`, `modified`, "
+        ReadConnection conn(baton->connection, baton->readers);
+        //                                               0       1         2
+        Statement &stmt = (*conn).prepare("SELECT `code`, `type`, `modified`, "
         //     3         4        5           6
             "`etag`, `expires`, `data`, `compressed` FROM `http_cache` WHERE `url` = ?");
 
@@ -134,93 +424,396 @@ void SQLiteStore::get(const std::string &path, GetCallback callback, void *ptr)
             baton->response->modified = stmt.get<int64_t>(2);
             baton->response->etag = stmt.get<std::string>(3);
             baton->response->expires = stmt.get<int64_t>(4);
-            baton->response->data = stmt.get<std::string>(5);
+            size_t length = 0;
+            const char *blob = stmt.getBlob(5, length);
             if (stmt.get<int>(6)) { // == compressed
-                baton->response->data = util::decompress(baton->response->data);
+                baton->response->data = util::decompress(blob, length);
+            } else {
+                baton->response->data = std::string(blob, length);
             }
+            baton->accessLog->record(url);
         } else {
             // There is no data.
             // This is a noop.
         }
+        stmt.reset();
     }, [](void *data) {
         std::unique_ptr<GetBaton> baton { (GetBaton *)data };
         if (baton->callback) {
             baton->callback(std::move(baton->response), baton->ptr);
         }
     });
+
+    // Store the access time in case this lookup hits.
+    scheduleFlush();
+}
+
+void SQLiteStore::put(const std::string &path, ResourceType type, const Response &response) {
+    assert(uv_thread_self() == thread_id);
+    if (!connection) return;
+
+    enqueue(path, [path, type, response](Connection &conn) {
+        const std::string url = unifyMapboxURLs(path);
+
+        // Replacing an entry keeps it pinned.
+        int64_t previousSize = 0;
+        int pinned = 0;
+        Statement &previous = conn.prepare("SELECT `size`, `pinned` FROM `http_cache` WHERE `url` = ?");
+        previous.bind(1, url.c_str());
+        if (previous.run()) {
+            previousSize = previous.get<int64_t>(0);
+            pinned = previous.get<int>(1);
+        }
+        previous.reset();
+
+        Statement &stmt = conn.prepare("REPLACE INTO `http_cache` ("
+        //     1      2       3         4         5         6        7          8             9         10       11
+            "`url`, `code`, `type`, `modified`, `etag`, `expires`, `data`, `compressed`, `accessed`, `size`, `pinned`"
+            ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        stmt.bind(1, url.c_str());
+        stmt.bind(2, int(response.code));
+        stmt.bind(3, int(type));
+        stmt.bind(4, response.modified);
+        stmt.bind(5, response.etag.c_str());
+        stmt.bind(6, response.expires);
+
+        // Data that is compressed already, like images, raster tiles or tiles that were served
+        // gzipped without a Content-Encoding, is stored as it is. So is data that compresses
+        // poorly, which saves inflating it on every hit.
+        size_t size = response.data.size();
+        std::string compressed;
+        if (type != ResourceType::Image && !util::isCompressed(response.data.data(), size)) {
+            compressed = util::compress(response.data.data(), size);
+        }
+        if (!compressed.empty() && compressed.size() < size - size / 8) {
+            // retain the string internally.
+            stmt.bind(7, compressed, true);
+            stmt.bind(8, true);
+            size = compressed.size();
+        } else {
+            // do not retain the data internally.
+            stmt.bind(7, response.data.data(), size, false);
+            stmt.bind(8, false);
+        }
+        stmt.bind<int64_t>(9, currentTime());
+        stmt.bind<int64_t>(10, size);
+        stmt.bind(11, pinned);
+
+        stmt.run();
+        conn.size += int64_t(size) - previousSize;
+    });
 }
 
+void SQLiteStore::updateExpiration(const std::string &path, int64_t expires) {
+    assert(uv_thread_self() == thread_id);
+    if (!connection || !connection->db) return;
+
+    enqueue(path, [path, expires](Connection &conn) {
+        const std::string url = unifyMapboxURLs(path);
+        Statement &stmt = //                     1               2
+            conn.prepare("UPDATE `http_cache` SET `expires` = ? WHERE `url` = ?");
+        stmt.bind<int64_t>(1, expires);
+        stmt.bind(2, url.c_str());
+        stmt.run();
+    });
+}
 
-struct PutBaton {
-    util::ptr<Database> db;
+struct GetBucketsBaton {
+    util::ptr<SQLiteStore::Connection> connection;
+    util::ptr<SQLiteStore::ConnectionPool> readers;
     std::string path;
-    ResourceType type;
-    Response response;
+    std::string key;
+    void *ptr = nullptr;
+    SQLiteStore::GetBucketsCallback callback = nullptr;
+    std::unique_ptr<std::string> data;
 };
 
-void SQLiteStore::put(const std::string &path, ResourceType type, const Response &response) {
+void SQLiteStore::getBuckets(const std::string &path, const std::string &key, GetBucketsCallback callback, void *ptr) {
     assert(uv_thread_self() == thread_id);
-    if (!db) return;
+    if (!connection || !connection->db) {
+        if (callback) {
+            callback(nullptr, ptr);
+        }
+        return;
+    }
 
-    PutBaton *put_baton = new PutBaton;
-    put_baton->db = db;
-    put_baton->path = path;
-    put_baton->type = type;
-    put_baton->response = response;
+    // Make sure that we read our own writes.
+    if (pendingPaths.count(path)) {
+        flush();
+    }
 
-    uv_worker_send(worker, put_baton, [](void *data) {
-        PutBaton *baton = (PutBaton *)data;
+    GetBucketsBaton *get_baton = new GetBucketsBaton;
+    get_baton->readers = readers;
+    get_baton->path = path;
+    get_baton->key = key;
+    get_baton->ptr = ptr;
+    get_baton->callback = callback;
+
+    uv_worker_t *target = reader_worker;
+    if (committingPaths->count(path)) {
+        get_baton->connection = connection;
+        target = worker;
+    }
+
+    uv_worker_send(target, get_baton, [](void *data) {
+        GetBucketsBaton *baton = (GetBucketsBaton *)data;
         const std::string url = unifyMapboxURLs(baton->path);
-        Statement stmt = baton->db->prepare("REPLACE INTO `http_cache` ("
-        //     1      2       3         4         5         6        7          8
-            "`url`, `code`, `type`, `modified`, `etag`, `expires`, `data`, `compressed`"
-            ") VALUES(?, ?, ?, ?, ?, ?, ?, ?)");
+        ReadConnection conn(baton->connection, baton->readers);
+        Statement &stmt = //                                                    1                2
+            (*conn).prepare("SELECT `data` FROM `bucket_cache` WHERE `url` = ? AND `key` = ?");
         stmt.bind(1, url.c_str());
-        stmt.bind(2, int(baton->response.code));
-        stmt.bind(3, int(baton->type));
-        stmt.bind(4, baton->response.modified);
-        stmt.bind(5, baton->response.etag.c_str());
-        stmt.bind(6, baton->response.expires);
-
-        if (baton->type == ResourceType::Image) {
-            stmt.bind(7, baton->response.data, false); // do not retain the string internally.
-            stmt.bind(8, false);
-        } else {
-            stmt.bind(7, util::compress(baton->response.data), true); // retain the string internally.
-            stmt.bind(8, true);
+        stmt.bind(2, baton->key.c_str());
+        if (stmt.run()) {
+            try {
+                size_t length = 0;
+                const char *blob = stmt.getBlob(0, length);
+                baton->data = std::unique_ptr<std::string>(new std::string(util::decompress(blob, length)));
+            } catch (const std::exception &) {
+                // A corrupt entry is treated like a missing one and overwritten after parsing.
+            }
         }
+        stmt.reset();
+    }, [](void *data) {
+        std::unique_ptr<GetBucketsBaton> baton { (GetBucketsBaton *)data };
+        if (baton->callback) {
+            baton->callback(std::move(baton->data), baton->ptr);
+        }
+    });
+}
+
+void SQLiteStore::putBuckets(const std::string &path, const std::string &key, std::string &&serialized) {
+    assert(uv_thread_self() == thread_id);
+    if (!connection || !connection->db) return;
+
+    // std::function needs a copyable callable, so the data is shared instead of moved.
+    auto data = std::make_shared<const std::string>(std::move(serialized));
+    enqueue(path, [path, key, data](Connection &conn) {
+        const std::string url = unifyMapboxURLs(path);
+
+        // Buckets are only evicted along with their tile, so tiles that don't come from the
+        // HTTP cache, e.g. from MBTiles or local files, don't get an entry.
+        Statement &owner = conn.prepare("SELECT 1 FROM `http_cache` WHERE `url` = ?");
+        owner.bind(1, url.c_str());
+        const bool owned = owner.run();
+        owner.reset();
+        if (!owned) {
+            return;
+        }
+
+        // The entry replaces the buckets that were stored for another style.
+        int64_t previousSize = 0;
+        Statement &previous = conn.prepare("SELECT length(`data`) FROM `bucket_cache` WHERE `url` = ?");
+        previous.bind(1, url.c_str());
+        if (previous.run()) {
+            previousSize = previous.get<int64_t>(0);
+        }
+        previous.reset();
+
+        const std::string compressed = util::compress(*data);
+        Statement &stmt = conn.prepare("REPLACE INTO `bucket_cache` ("
+        //     1      2       3
+            "`url`, `key`, `data`"
+            ") VALUES(?, ?, ?)");
+        stmt.bind(1, url.c_str());
+        stmt.bind(2, key.c_str());
+        stmt.bind(3, compressed.data(), compressed.size(), false);
+        stmt.run();
+
+        conn.size += int64_t(compressed.size()) - previousSize;
+    });
+}
+
+void SQLiteStore::pin(const std::string &path) {
+    assert(uv_thread_self() == thread_id);
+    if (!connection || !connection->db) return;
 
+    enqueue(path, [path](Connection &conn) {
+        const std::string url = unifyMapboxURLs(path);
+        Statement &stmt = conn.prepare("UPDATE `http_cache` SET `pinned` = 1 WHERE `url` = ?");
+        stmt.bind(1, url.c_str());
         stmt.run();
+    });
+}
+
+struct GetUnpinnedBaton {
+    util::ptr<SQLiteStore::Connection> connection;
+    util::ptr<SQLiteStore::ConnectionPool> readers;
+    std::vector<std::string> paths;
+    void *ptr = nullptr;
+    SQLiteStore::GetUnpinnedCallback callback = nullptr;
+};
+
+void SQLiteStore::getUnpinned(std::vector<std::string> &&paths, GetUnpinnedCallback callback, void *ptr) {
+    assert(uv_thread_self() == thread_id);
+    if (!connection || !connection->db) {
+        if (callback) {
+            callback(std::move(paths), ptr);
+        }
+        return;
+    }
+
+    // Queued pins must be visible to the lookup, like our own writes are to get(): they are
+    // flushed, and while a batch with any of the paths is being committed, the lookup runs
+    // after it on the writer thread.
+    if (std::any_of(paths.begin(), paths.end(),
+                    [this](const std::string &path) { return pendingPaths.count(path); })) {
+        flush();
+    }
+
+    GetUnpinnedBaton *get_baton = new GetUnpinnedBaton;
+    get_baton->readers = readers;
+    get_baton->ptr = ptr;
+    get_baton->callback = callback;
+
+    uv_worker_t *target = reader_worker;
+    if (std::any_of(paths.begin(), paths.end(),
+                    [this](const std::string &path) { return committingPaths->count(path); })) {
+        get_baton->connection = connection;
+        target = worker;
+    }
+    get_baton->paths = std::move(paths);
+
+    uv_worker_send(target, get_baton, [](void *data) {
+        GetUnpinnedBaton *baton = (GetUnpinnedBaton *)data;
+        ReadConnection conn(baton->connection, baton->readers);
+        auto &unpinned = baton->paths;
+        unpinned.erase(std::remove_if(unpinned.begin(), unpinned.end(), [&conn](const std::string &path) {
+            const std::string url = unifyMapboxURLs(path);
+            Statement &stmt = (*conn).prepare("SELECT `pinned` FROM `http_cache` WHERE `url` = ?");
+            stmt.bind(1, url.c_str());
+            const bool pinned = stmt.run() && stmt.get<int>(0);
+            stmt.reset();
+            return pinned;
+        }), unpinned.end());
     }, [](void *data) {
-        delete (PutBaton *)data;
+        std::unique_ptr<GetUnpinnedBaton> baton { (GetUnpinnedBaton *)data };
+        if (baton->callback) {
+            baton->callback(std::move(baton->paths), baton->ptr);
+        }
     });
 }
 
-struct ExpirationBaton {
-    util::ptr<Database> db;
-    std::string path;
-    int64_t expires;
+void SQLiteStore::beginBulkWrites() {
+    assert(uv_thread_self() == thread_id);
+    bulkWriters++;
+}
+
+void SQLiteStore::endBulkWrites() {
+    assert(uv_thread_self() == thread_id);
+    assert(bulkWriters > 0);
+    if (--bulkWriters == 0) {
+        flush();
+    }
+}
+
+void SQLiteStore::setMaximumSize(uint64_t bytes) {
+    assert(uv_thread_self() == thread_id);
+    if (!connection) return;
+
+    enqueue("", [bytes](Connection &conn) {
+        conn.maximumSize = bytes;
+    });
+}
+
+void SQLiteStore::enqueue(const std::string &path, Write &&write) {
+    writes.emplace_back(std::move(write));
+    if (!path.empty()) {
+        pendingPaths.insert(path);
+    }
+
+    if (writes.size() >= (bulkWriters ? maxBulkBatchSize : maxBatchSize)) {
+        flush();
+    } else {
+        scheduleFlush();
+    }
+}
+
+void SQLiteStore::scheduleFlush() {
+    if (!uv_is_active((uv_handle_t *)flushTimer)) {
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
+        uv_timer_start(flushTimer, [](uv_timer_t *timer, int) {
+#else
+        uv_timer_start(flushTimer, [](uv_timer_t *timer) {
+#endif
+            static_cast<SQLiteStore *>(timer->data)->flush();
+        }, bulkWriters ? bulkFlushInterval : flushInterval, 0);
+    }
+}
+
+struct WriteBaton {
+    util::ptr<SQLiteStore::Connection> connection;
+    util::ptr<SQLiteStore::AccessLog> accessLog;
+    std::vector<std::function<void(SQLiteStore::Connection &)>> writes;
+    std::unordered_set<std::string> paths;
+    util::ptr<std::unordered_map<std::string, unsigned int>> committingPaths;
 };
 
-void SQLiteStore::updateExpiration(const std::string &path, int64_t expires) {
+void SQLiteStore::flush() {
     assert(uv_thread_self() == thread_id);
-    if (!db || !*db) return;
+    uv_timer_stop(flushTimer);
+    if (writes.empty() && accessLog->empty()) {
+        return;
+    }
 
-    ExpirationBaton *expiration_baton = new ExpirationBaton;
-    expiration_baton->db = db;
-    expiration_baton->path = path;
-    expiration_baton->expires = expires;
+    WriteBaton *write_baton = new WriteBaton;
+    write_baton->connection = connection;
+    write_baton->accessLog = accessLog;
+    write_baton->writes.swap(writes);
+    write_baton->paths.swap(pendingPaths);
+    write_baton->committingPaths = committingPaths;
+    for (const std::string &path : write_baton->paths) {
+        (*committingPaths)[path]++;
+    }
 
-    uv_worker_send(worker, expiration_baton, [](void *data) {
-        ExpirationBaton *baton = (ExpirationBaton *)data;
-        const std::string url = unifyMapboxURLs(baton->path);
-        Statement stmt = //                                 1               2
-            baton->db->prepare("UPDATE `http_cache` SET `expires` = ? WHERE `url` = ?");
-        stmt.bind<int64_t>(1, baton->expires);
-        stmt.bind(2, url.c_str());
-        stmt.run();
+    uv_worker_send(worker, write_baton, [](void *data) {
+        WriteBaton *baton = (WriteBaton *)data;
+        Connection &conn = *baton->connection;
+
+        try {
+            conn.prepare("BEGIN").run();
+            for (const auto &write : baton->writes) {
+                try {
+                    write(conn);
+                } catch (const std::exception &) {
+                    // Skip this entry; the others can still be committed.
+                }
+            }
+            for (const auto &access : baton->accessLog->drain()) {
+                Statement &stmt = //                     1                2
+                    conn.prepare("UPDATE `http_cache` SET `accessed` = ? WHERE `url` = ?");
+                stmt.bind<int64_t>(1, access.second);
+                stmt.bind(2, access.first.c_str());
+                stmt.run();
+            }
+            conn.prepare("COMMIT").run();
+
+            conn.evict();
+        } catch (const std::exception &) {
+            // Drop the batch; it's only a cache.
+            try {
+                conn.db.exec("ROLLBACK");
+            } catch (const std::exception &) {
+                // There was no open transaction.
+            }
+            try {
+                // The size was already updated for the writes that got rolled back.
+                Statement &total = conn.prepare(totalSizeQuery);
+                if (total.run()) {
+                    conn.size = total.get<int64_t>(0);
+                }
+                total.reset();
+            } catch (const std::exception &) {
+            }
+        }
     }, [](void *data) {
-        delete (ExpirationBaton *)data;
+        std::unique_ptr<WriteBaton> baton { (WriteBaton *)data };
+        auto &committing = *baton->committingPaths;
+        for (const std::string &path : baton->paths) {
+            auto it = committing.find(path);
+            if (it != committing.end() && --it->second == 0) {
+                committing.erase(it);
+            }
+        }
     });
 }
 
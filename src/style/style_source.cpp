@@ -1,6 +1,7 @@
 #include <mbgl/style/style_source.hpp>
 #include <mbgl/platform/platform.hpp>
 #include <mbgl/platform/log.hpp>
+#include <mbgl/util/token.hpp>
 
 #include <limits>
 
@@ -74,4 +75,20 @@ void SourceInfo::parseTileJSONProperties(const rapidjson::Value& value) {
     parse(value, bounds, "bounds");
 }
 
+std::string SourceInfo::tileURL(const Tile::ID &id, float pixelRatio) const {
+    if (tiles.empty()) {
+        return "";
+    }
+
+    // Spread the tiles over all URLs, e.g. to use several subdomains.
+    const std::string &tile = tiles[(id.x + id.y) % tiles.size()];
+    return util::replaceTokens(tile, [&](const std::string &token) -> std::string {
+        if (token == "z") return std::to_string(id.z);
+        if (token == "x") return std::to_string(id.x);
+        if (token == "y") return std::to_string(id.y);
+        if (token == "ratio") return (pixelRatio > 1.0 ? "@2x" : "");
+        return "";
+    });
+}
+
 }
@@ -10,53 +10,98 @@
 #include <mbgl/util/math.hpp>
 #include <mbgl/storage/file_source.hpp>
 #include <mbgl/platform/platform.hpp>
+#include <mbgl/platform/log.hpp>
 #include <mbgl/util/uv_detail.hpp>
 #include <algorithm>
 
 namespace mbgl {
 
 
-void FontStack::insert(uint32_t id, const SDFGlyph &glyph) {
-    std::lock_guard<std::mutex> lock(mtx);
-    metrics.emplace(id, glyph.metrics);
-    bitmaps.emplace(id, glyph.bitmap);
-    sdfs.emplace(id, glyph);
+GlyphBlock::GlyphBlock(uint32_t first_) : first(first_) {
 }
 
-const std::map<uint32_t, GlyphMetrics> &FontStack::getMetrics() const {
-    std::lock_guard<std::mutex> lock(mtx);
-    return metrics;
+void GlyphBlock::add(SDFGlyph &&glyph) {
+    const uint32_t index = glyph.id - first;
+    if (index < size && !present[index]) {
+        glyphs[index] = std::move(glyph);
+        present[index] = true;
+    }
 }
 
-const std::map<uint32_t, SDFGlyph> &FontStack::getSDFs() const {
-    std::lock_guard<std::mutex> lock(mtx);
-    return sdfs;
+FontStack::FontStack() {
+    for (std::atomic<const GlyphBlock *> &block : blocks) {
+        block.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+FontStack::~FontStack() {
+    for (std::atomic<const GlyphBlock *> &block : blocks) {
+        delete block.load(std::memory_order_relaxed);
+    }
+}
+
+void FontStack::insert(std::unique_ptr<GlyphBlock> &&block) {
+    const uint32_t index = block->first / GlyphBlock::size;
+    if (index >= blocks.size()) {
+        return;
+    }
+
+    const GlyphBlock *expected = nullptr;
+    if (blocks[index].compare_exchange_strong(expected, block.get(), std::memory_order_acq_rel)) {
+        block.release();
+
+        // Labels that were shaped without these glyphs need to be shaped again.
+        shapings.clear();
+    }
+}
+
+const SDFGlyph *FontStack::getGlyph(uint32_t id) const {
+    const uint32_t index = id / GlyphBlock::size;
+    if (index >= blocks.size()) {
+        return nullptr;
+    }
+
+    const GlyphBlock *block = blocks[index].load(std::memory_order_acquire);
+    return block ? block->get(id) : nullptr;
+}
+
+const GlyphMetrics *FontStack::findMetrics(uint32_t id) const {
+    const SDFGlyph *glyph = getGlyph(id);
+    return glyph ? &glyph->metrics : nullptr;
 }
 
 const Shaping FontStack::getShaping(const std::u32string &string, const float maxWidth,
                                     const float lineHeight, const float horizontalAlign,
                                     const float verticalAlign, const float justify,
                                     const float spacing, const vec2<float> &translate) const {
-    std::lock_guard<std::mutex> lock(mtx);
+    ShapingKey key { string, maxWidth, lineHeight, horizontalAlign, verticalAlign, justify,
+                     spacing, translate };
 
     Shaping shaping;
+    if (shapings.get(key, shaping)) {
+        return shaping;
+    }
+
+    const uint64_t generation = shapings.getGeneration();
 
     int32_t x = std::round(translate.x * 24); // one em
     const int32_t y = std::round(translate.y * 24); // one em
 
     // Loop through all characters of this label and shape.
+    shaping.reserve(string.size());
     for (uint32_t chr : string) {
         shaping.emplace_back(chr, x, y);
-        auto metric = metrics.find(chr);
-        if (metric != metrics.end()) {
-            x += metric->second.advance + spacing;
+        const GlyphMetrics *metric = findMetrics(chr);
+        if (metric) {
+            x += metric->advance + spacing;
         }
     }
 
-    if (!shaping.size())
-        return shaping;
+    if (shaping.size()) {
+        lineWrap(shaping, lineHeight, maxWidth, horizontalAlign, verticalAlign, justify);
+    }
 
-    lineWrap(shaping, lineHeight, maxWidth, horizontalAlign, verticalAlign, justify);
+    shapings.add(std::move(key), shaping, generation);
 
     return shaping;
 }
@@ -73,12 +118,11 @@ void align(Shaping &shaping, const float justify, const float horizontalAlign,
     }
 }
 
-void justifyLine(Shaping &shaping, const std::map<uint32_t, GlyphMetrics> &metrics, uint32_t start,
-                 uint32_t end, float justify) {
-    PositionedGlyph &glyph = shaping[end];
-    auto metric = metrics.find(glyph.glyph);
-    if (metric != metrics.end()) {
-        const uint32_t lastAdvance = metric->second.advance;
+void justifyLine(Shaping &shaping, const GlyphMetrics *metric, uint32_t start, uint32_t end,
+                 float justify) {
+    if (metric) {
+        PositionedGlyph &glyph = shaping[end];
+        const uint32_t lastAdvance = metric->advance;
         const float lineIndent = float(glyph.x + lastAdvance) * justify;
 
         for (uint32_t j = start; j <= end; j++) {
@@ -116,7 +160,8 @@ void FontStack::lineWrap(Shaping &shaping, const float lineHeight, const float m
                 }
 
                 if (justify) {
-                    justifyLine(shaping, metrics, lineStartIndex, lastSafeBreak - 1, justify);
+                    justifyLine(shaping, findMetrics(shaping[lastSafeBreak - 1].glyph),
+                                lineStartIndex, lastSafeBreak - 1, justify);
                 }
 
                 lineStartIndex = lastSafeBreak + 1;
@@ -133,45 +178,67 @@ void FontStack::lineWrap(Shaping &shaping, const float lineHeight, const float m
 
     if (!maxLineLength) maxLineLength = shaping.back().x;
 
-    justifyLine(shaping, metrics, lineStartIndex, uint32_t(shaping.size()) - 1, justify);
+    justifyLine(shaping, findMetrics(shaping.back().glyph), lineStartIndex,
+                uint32_t(shaping.size()) - 1, justify);
     align(shaping, justify, horizontalAlign, verticalAlign, maxLineLength, lineHeight, line);
 }
 
-GlyphPBF::GlyphPBF(const std::string &glyphURL, const std::string &fontStack, GlyphRange glyphRange, FileSource& fileSource)
-    : future(promise.get_future().share())
-{
-    // Load the glyph set URL
-    std::string url = util::replaceTokens(glyphURL, [&](const std::string &name) -> std::string {
+std::string GlyphPBF::getURL(const std::string &glyphURL, const std::string &fontStack, GlyphRange glyphRange) {
+    return util::replaceTokens(glyphURL, [&](const std::string &name) -> std::string {
         if (name == "fontstack") return util::percentEncode(fontStack);
         if (name == "range") return std::to_string(glyphRange.first) + "-" + std::to_string(glyphRange.second);
         return "";
     });
+}
+
+GlyphPBF::GlyphPBF(const std::string &glyphURL, const std::string &fontStack, GlyphRange glyphRange, FileSource& fileSource)
+    : range(glyphRange) {
+    // Load the glyph set URL
+    std::string url = getURL(glyphURL, fontStack, glyphRange);
 
     // The prepare call jumps back to the main thread.
     fileSource.prepare([&, url] {
         auto request = fileSource.request(ResourceType::Glyphs, url);
         request->onload([&, url](const Response &res) {
             if (res.code != 200) {
-                // Something went wrong with loading the glyph pbf. Pass on the error to the future listeners.
-                const std::string msg = util::sprintf<255>("[ERROR] failed to load glyphs (%d): %s\n", res.code, res.message.c_str());
-                promise.set_exception(std::make_exception_ptr(std::runtime_error(msg)));
+                // Something went wrong with loading the glyph pbf. We still signal completion
+                // so that waiting tiles are parsed without the glyphs of this range.
+                Log::Warning(Event::General, "Failed to load glyphs (%d): %s", res.code, res.message.c_str());
+                complete({});
             } else {
                 // Transfer the data to the GlyphSet and signal its availability.
                 // Once it is available, the caller will need to call parse() to actually
-                // parse the data we received. We are not doing this here since this callback is being
-                // called from another (unknown) thread.
-                data = res.data;
-                promise.set_value(*this);
+                // parse the data we received. We are not doing this here since this is the
+                // map thread, and parsing happens in the worker threads.
+                complete(res.data);
             }
         });
         request->oncancel([&]() {
-            promise.set_exception(std::make_exception_ptr(std::runtime_error("Loading glyphs was canceled")));
+            complete({});
         });
     });
 }
 
-std::shared_future<GlyphPBF &> GlyphPBF::getFuture() {
-    return future;
+void GlyphPBF::complete(util::Blob data_) {
+    std::vector<std::function<void()>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        data = std::move(data_);
+        loaded = true;
+        pending.swap(callbacks);
+    }
+
+    for (const auto &callback : pending) {
+        callback();
+    }
+}
+
+bool GlyphPBF::isLoaded(const std::function<void()> &callback) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!loaded) {
+        callbacks.push_back(callback);
+    }
+    return loaded;
 }
 
 void GlyphPBF::parse(FontStack &stack) {
@@ -183,6 +250,9 @@ void GlyphPBF::parse(FontStack &stack) {
         return;
     }
 
+    // All glyphs of the range are published at once, when parsing has finished.
+    std::unique_ptr<GlyphBlock> block = std::make_unique<GlyphBlock>(range.first);
+
     // Parse the glyph PBF
     pbf glyphs_pbf(reinterpret_cast<const uint8_t *>(data.data()), data.size());
 
@@ -215,7 +285,7 @@ void GlyphPBF::parse(FontStack &stack) {
                         }
                     }
 
-                    stack.insert(glyph.id, glyph);
+                    block->add(std::move(glyph));
                 } else {
                     fontstack_pbf.skip();
                 }
@@ -225,7 +295,9 @@ void GlyphPBF::parse(FontStack &stack) {
         }
     }
 
-    data.clear();
+    stack.insert(std::move(block));
+
+    data = {};
 }
 
 GlyphStore::GlyphStore(FileSource& fileSource_) : fileSource(fileSource_) {}
@@ -235,17 +307,16 @@ void GlyphStore::setURL(const std::string &url) {
 }
 
 
-void GlyphStore::waitForGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges) {
-    // We are implementing a blocking wait with futures: Every GlyphSet has a future that we are
-    // waiting for until it is loaded.
+bool GlyphStore::hasGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges,
+                                const std::function<void()> &callback) {
     if (glyphRanges.empty()) {
-        return;
+        return true;
     }
 
     FontStack *stack = nullptr;
 
-    std::vector<std::shared_future<GlyphPBF &>> futures;
-    futures.reserve(glyphRanges.size());
+    std::vector<GlyphPBF *> pbfs;
+    pbfs.reserve(glyphRanges.size());
     {
         std::lock_guard<std::mutex> lock(mtx);
         auto &rangeSets = ranges[fontStack];
@@ -253,28 +324,32 @@ void GlyphStore::waitForGlyphRanges(const std::string &fontStack, const std::set
         stack = &createFontStack(fontStack);
 
         // Attempt to load the glyph range. If the GlyphSet already exists, we are getting back
-        // the same shared_future.
+        // the same object. This starts loading all missing ranges at once.
         for (GlyphRange range : glyphRanges) {
-            futures.emplace_back(loadGlyphRange(fontStack, rangeSets, range));
+            pbfs.emplace_back(&loadGlyphRange(fontStack, rangeSets, range));
         }
     }
 
-    // Now that we potentially created all GlyphSets, we are waiting for the results, one by one.
-    // When we get a result (or the GlyphSet is aready loaded), we are attempting to parse the
-    // GlyphSet.
-    for (std::shared_future<GlyphPBF &> &future : futures) {
-        future.get().parse(*stack);
+    // Parse the GlyphSets that are already loaded. We only register the callback with the first
+    // GlyphSet that is still loading; the caller checks again once it is invoked.
+    for (GlyphPBF *pbf : pbfs) {
+        if (!pbf->isLoaded(callback)) {
+            return false;
+        }
+        pbf->parse(*stack);
     }
+
+    return true;
 }
 
-std::shared_future<GlyphPBF &> GlyphStore::loadGlyphRange(const std::string &fontStack, std::map<GlyphRange, std::unique_ptr<GlyphPBF>> &rangeSets, const GlyphRange range) {
+GlyphPBF &GlyphStore::loadGlyphRange(const std::string &fontStack, std::map<GlyphRange, std::unique_ptr<GlyphPBF>> &rangeSets, const GlyphRange range) {
     auto range_it = rangeSets.find(range);
     if (range_it == rangeSets.end()) {
         // We don't have this glyph set yet for this font stack.
         range_it = rangeSets.emplace(range, std::make_unique<GlyphPBF>(glyphURL, fontStack, range, fileSource)).first;
     }
 
-    return range_it->second->getFuture();
+    return *range_it->second;
 }
 
 FontStack &GlyphStore::createFontStack(const std::string &fontStack) {
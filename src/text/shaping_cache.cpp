@@ -0,0 +1,63 @@
+#include <mbgl/text/shaping_cache.hpp>
+
+#include <functional>
+
+namespace mbgl {
+
+bool ShapingKey::operator==(const ShapingKey &other) const {
+    return maxWidth == other.maxWidth && lineHeight == other.lineHeight &&
+           horizontalAlign == other.horizontalAlign && verticalAlign == other.verticalAlign &&
+           justify == other.justify && spacing == other.spacing &&
+           translate == other.translate && string == other.string;
+}
+
+size_t ShapingKeyHash::operator()(const ShapingKey &key) const {
+    size_t seed = std::hash<std::u32string>()(key.string);
+    for (float value : { key.maxWidth, key.lineHeight, key.horizontalAlign, key.verticalAlign,
+                         key.justify, key.spacing, key.translate.x, key.translate.y }) {
+        seed ^= std::hash<float>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+ShapingCache::Shard &ShapingCache::shard(const ShapingKey &key) const {
+    // Labels with the same layout properties differ mostly in their text.
+    return shards[std::hash<std::u32string>()(key.string) % shardCount];
+}
+
+bool ShapingCache::get(const ShapingKey &key, Shaping &shaping) const {
+    Shard &s = shard(key);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    auto it = s.entries.find(key);
+    if (it == s.entries.end()) {
+        return false;
+    }
+    shaping = it->second;
+    return true;
+}
+
+void ShapingCache::add(ShapingKey &&key, const Shaping &shaping, uint64_t generation_) {
+    Shard &s = shard(key);
+    std::lock_guard<std::mutex> lock(s.mtx);
+
+    // clear() increments the generation before it empties the shards, so a shaping that was
+    // computed before that is either rejected here or removed by clear().
+    if (generation != generation_) {
+        return;
+    }
+
+    if (s.entries.size() >= maxShardEntries) {
+        s.entries.clear();
+    }
+    s.entries.emplace(std::move(key), shaping);
+}
+
+void ShapingCache::clear() {
+    generation++;
+    for (Shard &s : shards) {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        s.entries.clear();
+    }
+}
+
+}
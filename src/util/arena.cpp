@@ -0,0 +1,27 @@
+#include <mbgl/util/arena.hpp>
+
+#include <algorithm>
+
+namespace mbgl {
+namespace util {
+
+Arena::Arena(size_t chunkSize_) : chunkSize(chunkSize_) {}
+
+void *Arena::allocate(size_t size, size_t alignment) {
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(pos) + alignment - 1) & ~uintptr_t(alignment - 1);
+    if (!pos || begin + size > reinterpret_cast<uintptr_t>(end)) {
+        // Allocations that are larger than a chunk get a chunk of their own.
+        const size_t length = std::max(chunkSize, size + alignment);
+        chunks.emplace_back(new char[length]);
+        reserved += length;
+        pos = chunks.back().get();
+        end = pos + length;
+        begin = (reinterpret_cast<uintptr_t>(pos) + alignment - 1) & ~uintptr_t(alignment - 1);
+    }
+
+    pos = reinterpret_cast<char *>(begin + size);
+    return reinterpret_cast<void *>(begin);
+}
+
+}
+}
@@ -2,80 +2,171 @@
 
 #include <zlib.h>
 
+#include <pthread.h>
+
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 
 namespace mbgl {
 namespace util {
 
-std::string compress(const std::string &raw) {
+namespace {
+
+// Setting up a z_stream allocates the window and, for deflate, the hash tables. Every thread
+// keeps one stream of each kind and resets it between uses instead.
+struct Streams {
     z_stream deflate_stream;
-    memset(&deflate_stream, 0, sizeof(deflate_stream));
+    z_stream inflate_stream;
+    bool deflate_ready = false;
+    bool inflate_ready = false;
 
-    // TODO: reuse z_streams
-    if (deflateInit(&deflate_stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
-        throw std::runtime_error("failed to initialize deflate");
+    Streams() {
+        memset(&deflate_stream, 0, sizeof(deflate_stream));
+        memset(&inflate_stream, 0, sizeof(inflate_stream));
     }
 
-    deflate_stream.next_in = (Bytef *)raw.data();
-    deflate_stream.avail_in = uInt(raw.size());
+    ~Streams() {
+        if (deflate_ready) {
+            deflateEnd(&deflate_stream);
+        }
+        if (inflate_ready) {
+            inflateEnd(&inflate_stream);
+        }
+    }
 
-    std::string result;
-    char out[16384];
+    z_stream &deflater() {
+        if (!deflate_ready) {
+            if (deflateInit(&deflate_stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+                throw std::runtime_error("failed to initialize deflate");
+            }
+            deflate_ready = true;
+        } else {
+            deflateReset(&deflate_stream);
+        }
+        return deflate_stream;
+    }
 
-    int code;
-    do {
-        deflate_stream.next_out = reinterpret_cast<Bytef *>(out);
-        deflate_stream.avail_out = sizeof(out);
-        code = deflate(&deflate_stream, Z_FINISH);
-        if (result.size() < deflate_stream.total_out) {
-            // append the block to the output string
-            result.append(out, deflate_stream.total_out - result.size());
+    z_stream &inflater() {
+        if (!inflate_ready) {
+            // Detect zlib and gzip headers.
+            if (inflateInit2(&inflate_stream, MAX_WBITS + 32) != Z_OK) {
+                throw std::runtime_error("failed to initialize inflate");
+            }
+            inflate_ready = true;
+        } else {
+            inflateReset(&inflate_stream);
         }
-    } while (code == Z_OK);
+        return inflate_stream;
+    }
+};
+
+Streams &streams() {
+    // Note: libuv 0.10 doesn't have uv_key_* functions yet, see ClassDictionary::Get().
+    static pthread_once_t store_once = PTHREAD_ONCE_INIT;
+    static pthread_key_t store_key;
+
+    pthread_once(&store_once, []() {
+        pthread_key_create(&store_key, [](void *ptr) {
+            delete reinterpret_cast<Streams *>(ptr);
+        });
+    });
+
+    Streams *ptr = reinterpret_cast<Streams *>(pthread_getspecific(store_key));
+    if (ptr == nullptr) {
+        ptr = new Streams();
+        pthread_setspecific(store_key, ptr);
+    }
+
+    return *ptr;
+}
+
+bool isGzip(const char *data, size_t length) {
+    return length >= 18 && uint8_t(data[0]) == 0x1F && uint8_t(data[1]) == 0x8B;
+}
 
-    deflateEnd(&deflate_stream);
+bool isZlib(const char *data, size_t length) {
+    // Deflate with a window of at most 32 KB, and a valid header checksum.
+    return length >= 6 && (uint8_t(data[0]) & 0x8F) == 0x08 &&
+           ((uint8_t(data[0]) << 8) | uint8_t(data[1])) % 31 == 0;
+}
+
+}
+
+std::string compress(const std::string &raw) {
+    return compress(raw.data(), raw.size());
+}
+
+std::string compress(const char *raw, size_t length) {
+    z_stream &deflate_stream = streams().deflater();
+
+    // The bound is large enough to compress everything in a single call.
+    std::string result(deflateBound(&deflate_stream, uLong(length)), '\0');
+
+    deflate_stream.next_in = (Bytef *)raw;
+    deflate_stream.avail_in = uInt(length);
+    deflate_stream.next_out = reinterpret_cast<Bytef *>(&result[0]);
+    deflate_stream.avail_out = uInt(result.size());
 
+    const int code = deflate(&deflate_stream, Z_FINISH);
     if (code != Z_STREAM_END) {
-        throw std::runtime_error(deflate_stream.msg);
+        throw std::runtime_error(deflate_stream.msg ? deflate_stream.msg : "failed to deflate");
     }
 
+    result.resize(deflate_stream.total_out);
     return result;
 }
 
 std::string decompress(const std::string &raw) {
-    z_stream inflate_stream;
-    memset(&inflate_stream, 0, sizeof(inflate_stream));
+    return decompress(raw.data(), raw.size());
+}
 
-    // TODO: reuse z_streams
-    if (inflateInit(&inflate_stream) != Z_OK) {
-        throw std::runtime_error("failed to initialize inflate");
+std::string decompress(const char *raw, size_t length) {
+    z_stream &inflate_stream = streams().inflater();
+
+    // The result is inflated in place, so it can be handed on without another copy. Gzip
+    // streams end with the uncompressed size (modulo 4 GB); otherwise the buffer grows as needed.
+    size_t size = length * 4;
+    if (isGzip(raw, length)) {
+        const uint8_t *end = reinterpret_cast<const uint8_t *>(raw + length);
+        size = size_t(end[-4]) | size_t(end[-3]) << 8 | size_t(end[-2]) << 16 | size_t(end[-1]) << 24;
+        // Deflate can't compress by more than about 1:1032; don't trust larger sizes.
+        // One more byte lets inflate() finish without growing the buffer.
+        size = std::min(size, length * 1032) + 1;
     }
+    std::string result(std::max<size_t>(size, 1024), '\0');
 
-    inflate_stream.next_in = (Bytef *)raw.data();
-    inflate_stream.avail_in = uInt(raw.size());
-
-    std::string result;
-    char out[15384];
+    inflate_stream.next_in = (Bytef *)raw;
+    inflate_stream.avail_in = uInt(length);
 
     int code;
     do {
-        inflate_stream.next_out = reinterpret_cast<Bytef *>(out);
-        inflate_stream.avail_out = sizeof(out);
-        code = inflate(&inflate_stream, 0);
-        // result.append(out, sizeof(out) - inflate_stream.avail_out);
-        if (result.size() < inflate_stream.total_out) {
-            result.append(out, inflate_stream.total_out - result.size());
+        if (inflate_stream.total_out == result.size()) {
+            result.resize(result.size() * 2);
         }
+        inflate_stream.next_out = reinterpret_cast<Bytef *>(&result[inflate_stream.total_out]);
+        inflate_stream.avail_out = uInt(result.size() - inflate_stream.total_out);
+        code = inflate(&inflate_stream, Z_NO_FLUSH);
     } while (code == Z_OK);
 
-    inflateEnd(&inflate_stream);
-
     if (code != Z_STREAM_END) {
-        throw std::runtime_error(inflate_stream.msg);
+        throw std::runtime_error(inflate_stream.msg ? inflate_stream.msg : "failed to inflate");
     }
 
+    result.resize(inflate_stream.total_out);
     return result;
 }
+
+bool isCompressed(const char *data, size_t length) {
+    if (isGzip(data, length) || isZlib(data, length)) {
+        return true;
+    }
+
+    // PNG, JPEG and WebP images.
+    return (length >= 8 && std::memcmp(data, "\x89PNG\r\n\x1A\n", 8) == 0) ||
+           (length >= 3 && std::memcmp(data, "\xFF\xD8\xFF", 3) == 0) ||
+           (length >= 12 && std::memcmp(data, "RIFF", 4) == 0 && std::memcmp(data + 8, "WEBP", 4) == 0);
+}
+
 }
 }
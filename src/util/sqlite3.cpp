@@ -10,6 +10,8 @@ Database::Database(const std::string &filename, int flags) {
     const int err = sqlite3_open_v2(filename.c_str(), &db, flags, nullptr);
     if (err != SQLITE_OK) {
         Exception ex { err, sqlite3_errmsg(db) };
+        // The handle is allocated even if opening fails.
+        sqlite3_close(db);
         db = nullptr;
         throw ex;
     }
@@ -121,6 +123,10 @@ void Statement::bind(int offset, const std::string &value, bool retain) {
     BIND_5(blob, value.data(), int(value.size()), retain ? SQLITE_TRANSIENT : SQLITE_STATIC)
 }
 
+void Statement::bind(int offset, const char *value, size_t length, bool retain) {
+    BIND_5(blob, value, int(length), retain ? SQLITE_TRANSIENT : SQLITE_STATIC)
+}
+
 bool Statement::run() {
     assert(stmt);
     const int err = sqlite3_step(stmt);
@@ -156,6 +162,13 @@ template <> std::string Statement::get(int offset) {
     };
 }
 
+const char *Statement::getBlob(int offset, size_t &length) {
+    assert(stmt);
+    const char *value = reinterpret_cast<const char *>(sqlite3_column_blob(stmt, offset));
+    length = size_t(sqlite3_column_bytes(stmt, offset));
+    return value;
+}
+
 void Statement::reset() {
     assert(stmt);
     sqlite3_reset(stmt);
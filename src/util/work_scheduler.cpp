@@ -0,0 +1,404 @@
+#include <mbgl/util/work_scheduler.hpp>
+#include <mbgl/util/uv-messenger.h>
+#include <mbgl/util/std.hpp>
+
+#include <uv.h>
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __APPLE__
+#include <pthread.h>
+#endif
+
+namespace mbgl {
+namespace util {
+
+WorkRequest::WorkRequest(double priority_, uint64_t sequence_, WorkCallback work_, AfterWorkCallback after_)
+    : priority(priority_),
+      canceled(false),
+      sequence(sequence_),
+      work(std::move(work_)),
+      after(std::move(after_)) {
+}
+
+void WorkRequest::setPriority(double priority_) {
+    priority = priority_;
+}
+
+double WorkRequest::getPriority() const {
+    return priority;
+}
+
+void WorkRequest::cancel() {
+    canceled = true;
+}
+
+bool WorkRequest::isCanceled() const {
+    return canceled;
+}
+
+
+class WorkScheduler::Impl : private util::noncopyable {
+public:
+    Impl(uv_loop_t *loop, unsigned int count, const char *name);
+
+    util::ptr<WorkRequest> add(double priority, WorkRequest::WorkCallback work,
+                               WorkRequest::AfterWorkCallback after);
+    void parallel(const std::vector<std::function<void()>> &tasks);
+    void terminate();
+
+    const unsigned int count;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::vector<util::ptr<WorkRequest>> requests;
+    };
+
+    // Tasks of a parallel() call. Threads claim tasks by incrementing next.
+    struct Batch {
+        Batch(const std::vector<std::function<void()>> &tasks_) : tasks(tasks_), size(tasks_.size()) {}
+
+        // Only valid until the caller of parallel() returns, which is after all tasks have
+        // finished, so only access it while holding a claimed task.
+        const std::vector<std::function<void()>> &tasks;
+        const size_t size;
+        std::atomic<size_t> next { 0 };
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        size_t finished = 0;
+        std::exception_ptr error;
+    };
+
+    // Sent from the worker threads to the loop thread.
+    struct Message {
+        Impl *impl;
+        util::ptr<WorkRequest> request;
+
+        // When request is empty, the thread with this index has terminated.
+        unsigned int thread;
+    };
+
+    void run(unsigned int index);
+    util::ptr<WorkRequest> take(unsigned int index);
+    static util::ptr<WorkRequest> takeBest(Queue &queue);
+    util::ptr<Batch> takeBatch();
+    void runBatch(const util::ptr<Batch> &batch);
+    static void deliver(void *data);
+    void threadFinished(unsigned int index);
+
+private:
+#ifndef NDEBUG
+    const unsigned long thread_id;
+#endif
+    const char *name;
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    // Idle threads wait on this condition variable until work is added.
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t pending = 0;
+    std::vector<util::ptr<Batch>> batches;
+    bool terminating = false;
+
+    // These are only accessed in the loop thread.
+    uv_messenger_t *msgr;
+    unsigned int next_queue = 0;
+    uint64_t sequence = 0;
+    unsigned int active_items = 0;
+    unsigned int running_threads = 0;
+};
+
+WorkScheduler::Impl::Impl(uv_loop_t *loop, unsigned int count_, const char *name_)
+    : count(count_),
+#ifndef NDEBUG
+      thread_id(uv_thread_self()),
+#endif
+      name(name_),
+      msgr(new uv_messenger_t) {
+    if (uv_messenger_init(loop, msgr, deliver) != 0) {
+        delete msgr;
+        throw std::runtime_error("failed to initialize messenger");
+    }
+    uv_messenger_unref(msgr);
+
+    for (unsigned int i = 0; i < count; ++i) {
+        queues.emplace_back(std::make_unique<Queue>());
+    }
+
+    for (unsigned int i = 0; i < count; ++i) {
+        threads.emplace_back(&Impl::run, this, i);
+        running_threads++;
+    }
+}
+
+util::ptr<WorkRequest> WorkScheduler::Impl::add(double priority, WorkRequest::WorkCallback work,
+                                                WorkRequest::AfterWorkCallback after) {
+#ifndef NDEBUG
+    assert(uv_thread_self() == thread_id);
+#endif
+
+    auto request = std::make_shared<WorkRequest>(priority, sequence++, std::move(work), std::move(after));
+
+    Queue &queue = *queues[next_queue];
+    next_queue = (next_queue + 1) % count;
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.requests.push_back(request);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending++;
+    }
+    condition.notify_one();
+
+    if (active_items++ == 0) {
+        uv_messenger_ref(msgr);
+    }
+
+    return request;
+}
+
+void WorkScheduler::Impl::parallel(const std::vector<std::function<void()>> &tasks) {
+    if (tasks.size() < 2 || count < 2) {
+        for (const auto &task : tasks) {
+            task();
+        }
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>(tasks);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batches.push_back(batch);
+    }
+    condition.notify_all();
+
+    runBatch(batch);
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->condition.wait(lock, [&batch] { return batch->finished == batch->size; });
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+util::ptr<WorkScheduler::Impl::Batch> WorkScheduler::Impl::takeBatch() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return batches.empty() ? nullptr : batches.front();
+}
+
+void WorkScheduler::Impl::runBatch(const util::ptr<Batch> &batch) {
+    size_t finished = 0;
+    std::exception_ptr error;
+    for (size_t i = batch->next++; i < batch->size; i = batch->next++) {
+        try {
+            batch->tasks[i]();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        finished++;
+    }
+
+    // All tasks have been claimed, so no other thread needs to pick up this batch anymore.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find(batches.begin(), batches.end(), batch);
+        if (it != batches.end()) {
+            batches.erase(it);
+        }
+    }
+
+    if (finished) {
+        {
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            batch->finished += finished;
+            if (error && !batch->error) {
+                batch->error = error;
+            }
+        }
+        batch->condition.notify_all();
+    }
+}
+
+void WorkScheduler::Impl::terminate() {
+#ifndef NDEBUG
+    assert(uv_thread_self() == thread_id);
+#endif
+
+    // Queued requests are not going to run anymore. They are still handed back to the loop
+    // thread so that their callbacks are destroyed there.
+    for (const auto &queue : queues) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        for (const auto &request : queue->requests) {
+            request->cancel();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        terminating = true;
+    }
+    condition.notify_all();
+
+    // Keep the loop alive until all threads have terminated.
+    if (active_items++ == 0) {
+        uv_messenger_ref(msgr);
+    }
+}
+
+util::ptr<WorkRequest> WorkScheduler::Impl::takeBest(Queue &queue) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    auto &requests = queue.requests;
+    if (requests.empty()) {
+        return nullptr;
+    }
+
+    // Queues are short, so a linear scan is cheaper than keeping a heap up to date while the
+    // priorities keep changing.
+    auto best = std::min_element(requests.begin(), requests.end(),
+        [](const util::ptr<WorkRequest> &a, const util::ptr<WorkRequest> &b) {
+            const double pa = a->getPriority();
+            const double pb = b->getPriority();
+            return pa < pb || (pa == pb && a->sequence < b->sequence);
+        });
+
+    util::ptr<WorkRequest> request = std::move(*best);
+    requests.erase(best);
+    return request;
+}
+
+util::ptr<WorkRequest> WorkScheduler::Impl::take(unsigned int index) {
+    // Prefer our own queue, then try to steal from the others.
+    for (unsigned int i = 0; i < count; ++i) {
+        util::ptr<WorkRequest> request = takeBest(*queues[(index + i) % count]);
+        if (request) {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending--;
+            return request;
+        }
+    }
+    return nullptr;
+}
+
+void WorkScheduler::Impl::run(unsigned int index) {
+#ifdef __APPLE__
+    if (name) {
+        pthread_setname_np(name);
+    }
+#endif
+
+    while (true) {
+        util::ptr<WorkRequest> request = take(index);
+        if (request) {
+            if (!request->isCanceled()) {
+                request->work();
+                request->completed = true;
+            }
+
+            // Trigger the after callback in the loop thread.
+            uv_messenger_send(msgr, new Message { this, std::move(request), index });
+            continue;
+        }
+
+        // Help out with parallel() calls while we don't have anything else to do.
+        util::ptr<Batch> batch = takeBatch();
+        if (batch) {
+            runBatch(batch);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (pending == 0 && batches.empty()) {
+            if (terminating) {
+                break;
+            }
+            condition.wait(lock, [this] { return pending > 0 || !batches.empty() || terminating; });
+        }
+    }
+
+    uv_messenger_send(msgr, new Message { this, nullptr, index });
+}
+
+void WorkScheduler::Impl::deliver(void *data) {
+    std::unique_ptr<Message> message(static_cast<Message *>(data));
+    Impl *impl = message->impl;
+
+#ifndef NDEBUG
+    assert(uv_thread_self() == impl->thread_id);
+#endif
+
+    if (message->request) {
+        WorkRequest &request = *message->request;
+        if (request.after) {
+            request.after(request.completed);
+        }
+
+        // Release everything the callbacks captured in this thread.
+        request.work = nullptr;
+        request.after = nullptr;
+
+        assert(impl->active_items > 0);
+        if (--impl->active_items == 0) {
+            uv_messenger_unref(impl->msgr);
+        }
+    } else {
+        impl->threadFinished(message->thread);
+    }
+}
+
+void WorkScheduler::Impl::threadFinished(unsigned int index) {
+    // The thread has sent its termination message as the very last thing, so this won't block
+    // for long.
+    threads[index].join();
+
+    assert(running_threads > 0);
+    if (--running_threads == 0) {
+        uv_messenger_stop(msgr, [](uv_messenger_t *msgr_) {
+            delete msgr_;
+        });
+        delete this;
+    }
+}
+
+
+WorkScheduler::WorkScheduler(uv_loop_t *loop, unsigned int count, const char *name) {
+    if (count == 0) {
+        count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    impl = new Impl(loop, count, name);
+}
+
+WorkScheduler::~WorkScheduler() {
+    // The implementation deletes itself once all of its threads have terminated.
+    impl->terminate();
+}
+
+void WorkScheduler::parallel(const std::vector<std::function<void()>> &tasks) {
+    impl->parallel(tasks);
+}
+
+util::ptr<WorkRequest> WorkScheduler::add(double priority, WorkRequest::WorkCallback work,
+                                          WorkRequest::AfterWorkCallback after) {
+    return impl->add(priority, std::move(work), std::move(after));
+}
+
+unsigned int WorkScheduler::getThreadCount() const {
+    return impl->count;
+}
+
+}
+}
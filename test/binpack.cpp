@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/geometry/binpack.hpp>
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+bool overlaps(const Rect<uint16_t> &a, const Rect<uint16_t> &b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+}
+
+TEST(BinPack, Allocate) {
+    BinPack<uint16_t> bin(100, 100);
+
+    std::vector<Rect<uint16_t>> rects;
+    for (int i = 0; i < 25; i++) {
+        rects.push_back(bin.allocate(20, 20));
+        ASSERT_TRUE(rects.back());
+        EXPECT_LE(rects.back().x + rects.back().w, 100);
+        EXPECT_LE(rects.back().y + rects.back().h, 100);
+        for (size_t j = 0; j + 1 < rects.size(); j++) {
+            EXPECT_FALSE(overlaps(rects[j], rects.back()));
+        }
+    }
+
+    // The bin is full.
+    EXPECT_FALSE(bin.allocate(20, 20));
+    EXPECT_FALSE(bin.allocate(101, 1));
+
+    // Released space is reused.
+    bin.release(rects[7]);
+    const Rect<uint16_t> rect = bin.allocate(20, 20);
+    EXPECT_EQ(rects[7].x, rect.x);
+    EXPECT_EQ(rects[7].y, rect.y);
+}
+
+TEST(BinPack, Coalesce) {
+    BinPack<uint16_t> bin(100, 100);
+
+    std::vector<Rect<uint16_t>> rects;
+    for (int i = 0; i < 50; i++) {
+        rects.push_back(bin.allocate(10, 20));
+        ASSERT_TRUE(rects.back());
+    }
+
+    // Neighbors are merged, so that larger rectangles fit again. Release in an order that
+    // leaves gaps until the end.
+    for (size_t i = 0; i < rects.size(); i += 2) {
+        bin.release(rects[i]);
+    }
+    EXPECT_FALSE(bin.allocate(20, 20));
+    for (size_t i = 1; i < rects.size(); i += 2) {
+        bin.release(rects[i]);
+    }
+    EXPECT_TRUE(bin.allocate(100, 100));
+}
+
+TEST(BinPack, Grow) {
+    BinPack<uint16_t> bin(100, 20);
+    ASSERT_TRUE(bin.allocate(100, 20));
+    EXPECT_FALSE(bin.allocate(10, 10));
+
+    bin.grow(40);
+    const Rect<uint16_t> rect = bin.allocate(10, 10);
+    EXPECT_TRUE(rect);
+    EXPECT_EQ(20, rect.y);
+}
+
+// Simulates a long session of loading and unloading tiles, each of which adds the glyphs of its
+// labels to a 1024x1024 atlas. Prints the time it took; allocations must not start failing
+// because of fragmentation.
+TEST(BinPack, Session) {
+    BinPack<uint16_t> bin(1024, 1024);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> size(4, 10);
+
+    std::deque<std::vector<Rect<uint16_t>>> tiles;
+    size_t allocations = 0;
+    size_t failures = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int tile = 0; tile < 5000; tile++) {
+        std::vector<Rect<uint16_t>> glyphs;
+        for (int i = 0; i < 60; i++) {
+            const Rect<uint16_t> rect = bin.allocate(size(random) * 4, (size(random) + 2) * 4);
+            allocations++;
+            if (rect) {
+                glyphs.push_back(rect);
+            } else {
+                failures++;
+            }
+        }
+        tiles.push_back(std::move(glyphs));
+
+        if (tiles.size() > 10) {
+            for (const Rect<uint16_t> &rect : tiles.front()) {
+                bin.release(rect);
+            }
+            tiles.pop_front();
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    printf("%zu allocations, %zu failed, %.1f ms\n", allocations, failures,
+           std::chrono::duration<double, std::milli>(end - start).count());
+    EXPECT_EQ(0u, failures);
+
+    // Once everything is released, the whole bin is available again.
+    for (const std::vector<Rect<uint16_t>> &glyphs : tiles) {
+        for (const Rect<uint16_t> &rect : glyphs) {
+            bin.release(rect);
+        }
+    }
+    EXPECT_TRUE(bin.allocate(1024, 1024));
+}
@@ -101,3 +101,125 @@ TEST(FilterComparison, None) {
     ASSERT_FALSE(evaluate(parse("[\"none\", [\"==\", \"foo\", 0], [\"==\", \"foo\", 1]]"),
                           {{ std::string("foo"), int64_t(1) }}));
 }
+
+namespace {
+
+// Encodes vector tile layers for the CompiledFilterExpression tests.
+std::string varint(uint64_t value) {
+    std::string result;
+    while (value >= 0x80) {
+        result += char((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    result += char(value);
+    return result;
+}
+
+std::string message(uint32_t tag, const std::string &data) {
+    return varint((tag << 3) | 2) + varint(data.size()) + data;
+}
+
+std::string number(uint32_t tag, uint64_t value) {
+    return varint(tag << 3) + varint(value);
+}
+
+// Features are lists of (key, value) index pairs and a geometry type.
+struct TestFeature {
+    std::vector<uint32_t> tags;
+    uint32_t type;
+};
+
+std::string encodeLayer(const std::vector<std::string> &keys, const std::vector<std::string> &values,
+                        const std::vector<TestFeature> &features) {
+    std::string layer = message(1, "test");
+    for (const std::string &key : keys) {
+        layer += message(3, key);
+    }
+    for (const std::string &value : values) {
+        layer += message(4, value);
+    }
+    for (const TestFeature &feature : features) {
+        std::string tags;
+        for (uint32_t tag : feature.tags) {
+            tags += varint(tag);
+        }
+        layer += message(2, message(2, tags) + number(3, feature.type));
+    }
+    return layer;
+}
+
+// Extracts values from a feature of a decoded layer. Like the parser did before filters were
+// compiled, the last value of a duplicate key wins.
+class LayerExtractor {
+public:
+    LayerExtractor(const VectorTileLayer &layer_, uint32_t feature_) : layer(layer_), feature(feature_) {}
+
+    mapbox::util::optional<Value> getValue(const std::string &key) const {
+        if (key == "$type") {
+            return Value(uint64_t(layer.features.types[feature]));
+        }
+        mapbox::util::optional<Value> value;
+        const uint32_t *end = layer.features.tagsEnd(feature);
+        for (const uint32_t *tags = layer.features.tagsBegin(feature); tags != end; tags += 2) {
+            if (layer.keys[tags[0]] == key) {
+                value = layer.values[tags[1]];
+            }
+        }
+        return value;
+    }
+
+private:
+    const VectorTileLayer &layer;
+    const uint32_t feature;
+};
+
+}
+
+TEST(FilterComparison, CompiledMatchesEvaluate) {
+    const std::string data = encodeLayer(
+        { "name", "rank", "oneway" },
+        { message(1, "main"), message(1, "side"), number(5, 3), number(4, 10), number(7, 1) },
+        {
+            { { 0, 0, 1, 2 }, 1 },       // Point
+            { { 0, 1, 1, 3 }, 2 },       // LineString
+            { { 2, 4 }, 3 },             // Polygon
+            { {}, 0 },                   // Unknown, without tags
+            { { 0, 0, 0, 1 }, 2 },       // Duplicate key
+            { { 1, 2 }, 7 },             // Type that the spec doesn't define
+        });
+    util::Arena arena;
+    const VectorTileLayer layer(pbf(reinterpret_cast<const uint8_t *>(data.data()), data.size()), arena);
+    ASSERT_EQ(6u, layer.features.size());
+
+    const char *filters[] = {
+        "[\"==\", \"name\", \"main\"]",
+        "[\"!=\", \"name\", \"main\"]",
+        "[\"<\", \"rank\", 5]",
+        "[\"in\", \"name\", \"side\", \"other\"]",
+        "[\"!in\", \"name\", \"side\", \"other\"]",
+        "[\"has\", \"oneway\"]",
+        "[\"!has\", \"oneway\"]",
+        "[\"==\", \"missing\", 1]",
+        "[\"!=\", \"missing\", 1]",
+        "[\"has\", \"missing\"]",
+        "[\"!has\", \"missing\"]",
+        "[\"==\", \"$type\", \"LineString\"]",
+        "[\"!=\", \"$type\", \"Point\"]",
+        "[\"in\", \"$type\", \"Point\", \"Polygon\"]",
+        "[\"any\", [\"==\", \"name\", \"side\"], [\"has\", \"oneway\"]]",
+        "[\"all\", [\"==\", \"name\", \"main\"], [\"<\", \"rank\", 5]]",
+        "[\"none\", [\"==\", \"name\", \"main\"], [\"==\", \"$type\", \"Polygon\"]]",
+    };
+
+    for (const char *filter : filters) {
+        const FilterExpression expression = parse(filter);
+        const CompiledFilterExpression compiled(expression, layer);
+        // Evaluate twice, so that memoized results are checked as well.
+        for (int pass = 0; pass < 2; pass++) {
+            for (uint32_t feature = 0; feature < layer.features.size(); feature++) {
+                EXPECT_EQ(mbgl::evaluate(expression, LayerExtractor(layer, feature)), compiled.evaluate(feature))
+                    << filter << ", feature " << feature;
+            }
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/util/compression.hpp>
+
+#include <zlib.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+std::string gzip(const std::string &raw) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string result(deflateBound(&stream, uLong(raw.size())) + 32, '\0');
+    stream.next_in = (Bytef *)raw.data();
+    stream.avail_in = uInt(raw.size());
+    stream.next_out = (Bytef *)&result[0];
+    stream.avail_out = uInt(result.size());
+    deflate(&stream, Z_FINISH);
+    result.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result;
+}
+
+std::string sample(size_t length) {
+    std::string data;
+    while (data.size() < length) {
+        data += "{\"type\":\"Feature\",\"id\":" + std::to_string(data.size()) + "}";
+    }
+    data.resize(length);
+    return data;
+}
+
+}
+
+TEST(Compression, RoundTrip) {
+    for (size_t length : { 0, 1, 1000, 100000 }) {
+        const std::string raw = sample(length);
+        const std::string compressed = util::compress(raw);
+        EXPECT_TRUE(util::isCompressed(compressed.data(), compressed.size()));
+        EXPECT_EQ(raw, util::decompress(compressed));
+    }
+}
+
+TEST(Compression, Gzip) {
+    const std::string raw = sample(50000);
+    const std::string compressed = gzip(raw);
+    EXPECT_TRUE(util::isCompressed(compressed.data(), compressed.size()));
+    EXPECT_EQ(raw, util::decompress(compressed));
+}
+
+TEST(Compression, Invalid) {
+    EXPECT_THROW(util::decompress(std::string("not compressed")), std::runtime_error);
+
+    // Truncated data. The stream stays usable afterwards.
+    const std::string compressed = util::compress(sample(1000));
+    EXPECT_THROW(util::decompress(compressed.substr(0, compressed.size() / 2)), std::runtime_error);
+    EXPECT_EQ(sample(1000), util::decompress(compressed));
+}
+
+TEST(Compression, IsCompressed) {
+    const std::string png("\x89PNG\r\n\x1A\n\0\0\0\rIHDR", 16);
+    EXPECT_TRUE(util::isCompressed(png.data(), png.size()));
+    const std::string jpeg("\xFF\xD8\xFF\xE0\0\x10JFIF", 10);
+    EXPECT_TRUE(util::isCompressed(jpeg.data(), jpeg.size()));
+    const std::string webp("RIFF\0\0\0\0WEBPVP8 ", 16);
+    EXPECT_TRUE(util::isCompressed(webp.data(), webp.size()));
+
+    const std::string json = sample(100);
+    EXPECT_FALSE(util::isCompressed(json.data(), json.size()));
+    const std::string pbf("\x1A\x10\x0A\x05water", 9);
+    EXPECT_FALSE(util::isCompressed(pbf.data(), pbf.size()));
+}
+
+TEST(Compression, Threads) {
+    const std::string raw = sample(20000);
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for (size_t t = 0; t < failures.size(); t++) {
+        threads.emplace_back([&raw, &failures, t]() {
+            for (int i = 0; i < 50; i++) {
+                if (util::decompress(util::compress(raw)) != raw) {
+                    failures[t]++;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(std::vector<int>(4, 0), failures);
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/geometry/earcut.hpp>
+
+using namespace mbgl;
+
+typedef std::vector<ClipperLib::IntPoint> Ring;
+
+int64_t triangleArea(const Ring &vertices, const std::vector<uint16_t> &indices) {
+    int64_t area = 0;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const ClipperLib::IntPoint &a = vertices[indices[i]];
+        const ClipperLib::IntPoint &b = vertices[indices[i + 1]];
+        const ClipperLib::IntPoint &c = vertices[indices[i + 2]];
+        area += (b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X);
+    }
+    return area;
+}
+
+TEST(Earcut, Square) {
+    Earcut earcut;
+    ASSERT_TRUE(earcut.triangulate({ { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 }, { 0, 0 } }));
+    EXPECT_EQ(4u, earcut.vertices().size());
+    EXPECT_EQ(6u, earcut.indices().size());
+    EXPECT_EQ(200, triangleArea(earcut.vertices(), earcut.indices()));
+}
+
+TEST(Earcut, Concave) {
+    // An L-shaped building footprint.
+    Earcut earcut;
+    ASSERT_TRUE(earcut.triangulate({ { 0, 0 }, { 20, 0 }, { 20, 10 }, { 10, 10 }, { 10, 20 }, { 0, 20 } }));
+    EXPECT_EQ(6u, earcut.vertices().size());
+    EXPECT_EQ(12u, earcut.indices().size());
+    EXPECT_EQ(600, triangleArea(earcut.vertices(), earcut.indices()));
+}
+
+TEST(Earcut, Collinear) {
+    Earcut earcut;
+    ASSERT_TRUE(earcut.triangulate({ { 0, 0 }, { 5, 0 }, { 10, 0 }, { 10, 10 }, { 10, 10 }, { 0, 10 } }));
+    EXPECT_EQ(5u, earcut.vertices().size());
+    EXPECT_EQ(0u, earcut.indices().size() % 3);
+    EXPECT_EQ(200, triangleArea(earcut.vertices(), earcut.indices()));
+}
+
+TEST(Earcut, NegativeRing) {
+    // Rings with a negative area aren't filled with the positive winding rule.
+    Earcut earcut;
+    ASSERT_TRUE(earcut.triangulate({ { 0, 0 }, { 0, 10 }, { 10, 10 }, { 10, 0 } }));
+    EXPECT_TRUE(earcut.vertices().empty());
+    EXPECT_TRUE(earcut.indices().empty());
+}
+
+TEST(Earcut, Degenerate) {
+    Earcut earcut;
+    ASSERT_TRUE(earcut.triangulate({ { 0, 0 }, { 10, 0 }, { 0, 0 } }));
+    EXPECT_TRUE(earcut.vertices().empty());
+}
+
+TEST(Earcut, SelfIntersecting) {
+    Earcut earcut;
+    EXPECT_FALSE(earcut.triangulate({ { 0, 0 }, { 10, 10 }, { 10, 0 }, { 0, 10 } }));
+    // Touching itself in a single vertex.
+    EXPECT_FALSE(earcut.triangulate({ { 0, 0 }, { 10, 0 }, { 5, 5 }, { 10, 10 }, { 0, 10 }, { 5, 5 } }));
+}
+
+TEST(Earcut, TooLarge) {
+    Ring ring;
+    for (size_t i = 0; i <= Earcut::maxVertices; i++) {
+        ring.emplace_back(i, i % 2);
+    }
+    ring.emplace_back(Earcut::maxVertices, 100);
+    ring.emplace_back(0, 100);
+
+    Earcut earcut;
+    EXPECT_FALSE(earcut.triangulate(ring));
+}
@@ -0,0 +1,66 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/geometry/glyph_atlas.hpp>
+
+#include <array>
+
+using namespace mbgl;
+
+namespace {
+
+SDFGlyph makeGlyph(uint32_t id) {
+    SDFGlyph glyph;
+    glyph.id = id;
+    glyph.metrics.width = 18;
+    glyph.metrics.height = 18;
+    glyph.metrics.advance = 20;
+    glyph.bitmap = std::string(24 * 24, 'x');
+    return glyph;
+}
+
+typedef std::array<uint16_t, 4> Position;
+
+Position add(GlyphAtlas &atlas, uint64_t tile, const std::string &face, uint32_t id) {
+    const Rect<uint16_t> rect = atlas.addGlyph(tile, face, makeGlyph(id));
+    return {{ rect.x, rect.y, rect.w, rect.h }};
+}
+
+}
+
+TEST(GlyphAtlas, SharedGlyphs) {
+    GlyphAtlas atlas(256, 256);
+
+    const Position a = add(atlas, 1, "font", 'a');
+    EXPECT_EQ(a, add(atlas, 2, "font", 'a'));
+    EXPECT_EQ(a, add(atlas, 2, "font", 'a'));
+    const Position b = add(atlas, 1, "font", 'b');
+    EXPECT_NE(a, b);
+
+    // The same codepoint in another font stack is a different glyph.
+    EXPECT_NE(a, add(atlas, 1, "other", 'a'));
+
+    // Tile 2 still uses a, so it stays in place, while the space of b is released.
+    atlas.removeGlyphs(1);
+    EXPECT_EQ(a, add(atlas, 3, "font", 'a'));
+    EXPECT_EQ(b, add(atlas, 3, "font", 'c'));
+
+    // Removing unknown tiles is a no-op.
+    atlas.removeGlyphs(42);
+    EXPECT_EQ(a, add(atlas, 3, "font", 'a'));
+}
+
+TEST(GlyphAtlas, Grow) {
+    // Glyphs take 28x28 pixels, so 9 glyphs fit in each 256 pixel row.
+    GlyphAtlas atlas(256, 28, 56);
+
+    for (uint32_t id = 0; id < 18; id++) {
+        EXPECT_NE(0, atlas.addGlyph(1, "font", makeGlyph(id)).w) << id;
+    }
+    EXPECT_EQ(0, atlas.addGlyph(1, "font", makeGlyph(18)).w);
+
+    // Once a tile is removed, its space is available again.
+    atlas.removeGlyphs(1);
+    for (uint32_t id = 100; id < 118; id++) {
+        EXPECT_NE(0, atlas.addGlyph(2, "font", makeGlyph(id)).w) << id;
+    }
+}
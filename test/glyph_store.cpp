@@ -0,0 +1,126 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/text/glyph_store.hpp>
+
+#include <map>
+#include <thread>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+SDFGlyph makeGlyph(uint32_t id, uint32_t advance) {
+    SDFGlyph glyph;
+    glyph.id = id;
+    glyph.metrics.width = advance - 2;
+    glyph.metrics.height = 20;
+    glyph.metrics.advance = advance;
+    glyph.bitmap = std::string((glyph.metrics.width + 6) * (glyph.metrics.height + 6), 'x');
+    return glyph;
+}
+
+// Adds the glyphs to the font stack as one block per range.
+void insert(FontStack &stack, const std::vector<SDFGlyph> &glyphs) {
+    std::map<uint32_t, std::unique_ptr<GlyphBlock>> blocks;
+    for (const SDFGlyph &glyph : glyphs) {
+        std::unique_ptr<GlyphBlock> &block = blocks[glyph.id / GlyphBlock::size];
+        if (!block) {
+            block.reset(new GlyphBlock(glyph.id / GlyphBlock::size * GlyphBlock::size));
+        }
+        block->add(SDFGlyph(glyph));
+    }
+    for (auto &pair : blocks) {
+        stack.insert(std::move(pair.second));
+    }
+}
+
+Shaping shape(const FontStack &stack, const std::u32string &string, float maxWidth = 0) {
+    return stack.getShaping(string, maxWidth, 24, 0.5, 0.5, 0.5, 0, vec2<float>(0, 0));
+}
+
+std::vector<float> positions(const Shaping &shaping) {
+    std::vector<float> result;
+    for (const PositionedGlyph &glyph : shaping) {
+        result.push_back(glyph.x);
+        result.push_back(glyph.y);
+    }
+    return result;
+}
+
+}
+
+TEST(FontStack, Shaping) {
+    FontStack stack;
+    insert(stack, { makeGlyph('a', 10), makeGlyph('b', 12), makeGlyph(' ', 6) });
+
+    const Shaping shaping = shape(stack, U"ab");
+    ASSERT_EQ(2u, shaping.size());
+    EXPECT_EQ(std::vector<float>({ -11, 0, -1, 0 }), positions(shaping));
+
+    // The cached shaping is the same.
+    EXPECT_EQ(positions(shaping), positions(shape(stack, U"ab")));
+
+    // Different properties are cached separately.
+    EXPECT_NE(positions(shape(stack, U"ab ab ab")), positions(shape(stack, U"ab ab ab", 20)));
+
+    // Glyphs that were missing are taken into account once they are added.
+    const std::vector<float> missing = positions(shape(stack, U"a\u0100"));
+    insert(stack, { makeGlyph(0x100, 30) });
+    EXPECT_NE(missing, positions(shape(stack, U"a\u0100")));
+}
+
+TEST(FontStack, Blocks) {
+    FontStack stack;
+    EXPECT_EQ(nullptr, stack.getGlyph('a'));
+
+    std::unique_ptr<GlyphBlock> block(new GlyphBlock(0));
+    block->add(makeGlyph('a', 10));
+    block->add(makeGlyph(0x100, 10)); // Outside of the block.
+    const SDFGlyph *a = block->get('a');
+    stack.insert(std::move(block));
+
+    EXPECT_EQ(a, stack.getGlyph('a'));
+    EXPECT_EQ(10u, stack.getGlyph('a')->metrics.advance);
+    EXPECT_EQ(nullptr, stack.getGlyph('b'));
+    EXPECT_EQ(nullptr, stack.getGlyph(0x100));
+    EXPECT_EQ(nullptr, stack.getGlyph(0x10000));
+
+    // A range is only published once; readers may still use the glyphs of the first block.
+    insert(stack, { makeGlyph('a', 20), makeGlyph('b', 20) });
+    EXPECT_EQ(a, stack.getGlyph('a'));
+    EXPECT_EQ(nullptr, stack.getGlyph('b'));
+}
+
+TEST(FontStack, ConcurrentShaping) {
+    FontStack stack;
+    std::vector<SDFGlyph> glyphs;
+    for (uint32_t chr = 'a'; chr <= 'z'; chr++) {
+        glyphs.push_back(makeGlyph(chr, chr - 'a' + 5));
+    }
+    insert(stack, glyphs);
+
+    const std::vector<std::u32string> labels = { U"main street", U"high street", U"station road",
+                                                 U"park avenue", U"church lane" };
+    std::vector<std::vector<float>> expected;
+    for (const std::u32string &label : labels) {
+        expected.push_back(positions(shape(stack, label, 100)));
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for (size_t t = 0; t < failures.size(); t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 200; i++) {
+                const size_t l = (i + t) % labels.size();
+                if (positions(shape(stack, labels[l], 100)) != expected[l]) {
+                    failures[t]++;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(std::vector<int>(4, 0), failures);
+}
@@ -0,0 +1,120 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/sqlite3.hpp>
+
+#include <rapidjson/document.h>
+
+#include <uv.h>
+#include <zlib.h>
+
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+using namespace mbgl;
+using namespace mapbox::sqlite;
+
+namespace {
+
+std::string gzip(const std::string &raw) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string result(deflateBound(&stream, uLong(raw.size())) + 32, '\0');
+    stream.next_in = (Bytef *)raw.data();
+    stream.avail_in = uInt(raw.size());
+    stream.next_out = (Bytef *)&result[0];
+    stream.avail_out = uInt(result.size());
+    deflate(&stream, Z_FINISH);
+    result.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result;
+}
+
+class MBTilesTest : public ::testing::Test {
+protected:
+    void SetUp() {
+        char name[] = "/tmp/mbgl-XXXXXX.mbtiles";
+        const int fd = mkstemps(name, 8);
+        ASSERT_NE(-1, fd);
+        close(fd);
+        path = name;
+
+        Database db(path, ReadWrite | Create);
+        db.exec("CREATE TABLE metadata (name TEXT, value TEXT);"
+                "CREATE TABLE tiles (zoom_level INTEGER, tile_column INTEGER, tile_row INTEGER, tile_data BLOB);"
+                "INSERT INTO metadata VALUES ('name', 'Test'), ('format', 'pbf'), ('bounds', '-180,-85,180,85'),"
+                "    ('json', '{\"vector_layers\":[{\"id\":\"water\"}]}');");
+
+        Statement insert = db.prepare("INSERT INTO tiles VALUES (?, ?, ?, ?)");
+        const std::string compressed = gzip("compressed tile");
+        insert.bind(1, 2);
+        insert.bind(2, 1);
+        insert.bind(3, 0); // TMS row of y = 3 at z2.
+        insert.bind(4, compressed.data(), compressed.size());
+        insert.run();
+        insert.reset();
+
+        insert.bind(1, 0);
+        insert.bind(2, 0);
+        insert.bind(3, 0);
+        insert.bind(4, std::string("raw tile"));
+        insert.run();
+    }
+
+    void TearDown() {
+        unlink(path.c_str());
+    }
+
+    // Runs the request to completion and returns the response code and data.
+    std::pair<long, std::string> load(const std::string &url) {
+        std::pair<long, std::string> result { 0, "" };
+        uv_loop_t *loop = uv_loop_new();
+        {
+            FileSource fileSource(loop, "");
+            auto request = fileSource.request(ResourceType::Unknown, url);
+            request->onload([&](const Response &res) {
+                result = { res.code, res.data.str() };
+            });
+            uv_run(loop, UV_RUN_DEFAULT);
+        }
+        // Closes the worker threads.
+        uv_run(loop, UV_RUN_DEFAULT);
+        uv_loop_delete(loop);
+        return result;
+    }
+
+    std::string path;
+};
+
+}
+
+TEST_F(MBTilesTest, Tile) {
+    EXPECT_EQ(std::make_pair(200l, std::string("compressed tile")), load("mbtiles://" + path + "/2/1/3.pbf"));
+    EXPECT_EQ(std::make_pair(200l, std::string("raw tile")), load("mbtiles://" + path + "/0/0/0.pbf"));
+}
+
+TEST_F(MBTilesTest, MissingTile) {
+    EXPECT_EQ(404, load("mbtiles://" + path + "/2/1/0.pbf").first);
+    EXPECT_EQ(404, load("mbtiles://" + path + "/2/4/0.pbf").first);
+    EXPECT_EQ(500, load("mbtiles:///nonexistent.mbtiles/0/0/0.pbf").first);
+}
+
+TEST_F(MBTilesTest, TileJSON) {
+    const auto result = load("mbtiles://" + path);
+    ASSERT_EQ(200, result.first);
+
+    rapidjson::Document document;
+    document.Parse<0>(result.second.c_str());
+    ASSERT_FALSE(document.HasParseError());
+
+    EXPECT_EQ("mbtiles://" + path + "/{z}/{x}/{y}.pbf", std::string(document["tiles"][0u].GetString()));
+    EXPECT_EQ(std::string("Test"), document["name"].GetString());
+    EXPECT_EQ(0, document["minzoom"].GetInt());
+    EXPECT_EQ(2, document["maxzoom"].GetInt());
+    EXPECT_EQ(4u, document["bounds"].Size());
+    EXPECT_EQ(85, document["bounds"][3u].GetDouble());
+    EXPECT_EQ(std::string("water"), document["vector_layers"][0u]["id"].GetString());
+}
@@ -0,0 +1,161 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/map/offline_region.hpp>
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/storage/sqlite_store.hpp>
+#include <mbgl/util/io.hpp>
+#include <mbgl/util/sqlite3.hpp>
+
+#include <uv.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace mbgl;
+
+namespace {
+
+class OfflineRegionTest : public ::testing::Test {
+protected:
+    void SetUp() {
+        char name[] = "/tmp/mbgl-offline-XXXXXX";
+        ASSERT_TRUE(mkdtemp(name));
+        dir = name;
+        loop = uv_loop_new();
+    }
+
+    void TearDown() {
+        uv_loop_delete(loop);
+        for (const char *file : { "/style.json", "/sprite.json", "/tiles.mbtiles", "/cache.db",
+                                  "/cache.db-wal", "/cache.db-shm" }) {
+            unlink((dir + file).c_str());
+        }
+        rmdir(dir.c_str());
+    }
+
+    // Runs the loop until all callbacks have finished, then closes the worker threads.
+    void run(std::unique_ptr<FileSource> &fileSource) {
+        uv_run(loop, UV_RUN_DEFAULT);
+        fileSource.reset();
+        uv_run(loop, UV_RUN_DEFAULT);
+    }
+
+    std::string dir;
+    uv_loop_t *loop = nullptr;
+};
+
+}
+
+TEST_F(OfflineRegionTest, Tiles) {
+    std::unique_ptr<FileSource> fileSource(new FileSource(loop, ""));
+
+    OfflineRegion::Options options;
+    OfflineRegion world(*fileSource, options);
+    EXPECT_EQ(1u, world.tiles(0).size());
+    EXPECT_EQ(4u, world.tiles(1).size());
+    EXPECT_EQ(16u, world.tiles(2).size());
+
+    options.west = 9;
+    options.south = 9;
+    options.east = 11;
+    options.north = 11;
+    OfflineRegion small(*fileSource, options);
+    const auto tiles = small.tiles(2);
+    ASSERT_EQ(1u, tiles.size());
+    EXPECT_EQ(std::make_pair(2, 1), tiles[0]);
+
+    run(fileSource);
+}
+
+TEST_F(OfflineRegionTest, Download) {
+    {
+        using namespace mapbox::sqlite;
+        Database db(dir + "/tiles.mbtiles", ReadWrite | Create);
+        db.exec("CREATE TABLE metadata (name TEXT, value TEXT);"
+                "CREATE TABLE tiles (zoom_level INTEGER, tile_column INTEGER, tile_row INTEGER, tile_data BLOB);"
+                "INSERT INTO tiles VALUES (0, 0, 0, 'tile'), (2, 0, 0, 'tile');");
+    }
+
+    util::write_file(dir + "/sprite.json", "{}");
+    util::write_file(dir + "/style.json",
+        "{ \"version\": 6,"
+        "  \"sprite\": \"file://" + dir + "/sprite\","
+        "  \"glyphs\": \"file://" + dir + "/{fontstack}/{range}.pbf\","
+        "  \"sources\": { \"tiles\": { \"type\": \"vector\", \"url\": \"mbtiles://" + dir + "/tiles.mbtiles\" } },"
+        "  \"layers\": ["
+        "    { \"id\": \"water\", \"type\": \"fill\", \"source\": \"tiles\", \"source-layer\": \"water\" },"
+        "    { \"id\": \"label\", \"type\": \"symbol\", \"source\": \"tiles\", \"source-layer\": \"place\","
+        "      \"layout\": { \"text-field\": \"{name}\", \"text-font\": \"Open Sans\" } }"
+        "  ]"
+        "}");
+
+    std::unique_ptr<FileSource> fileSource(new FileSource(loop, dir + "/cache.db"));
+
+    OfflineRegion::Options options;
+    options.styleURL = "file://" + dir + "/style.json";
+    options.minZoom = 0;
+    options.maxZoom = 1;
+
+    auto region = std::make_shared<OfflineRegion>(*fileSource, options);
+    std::vector<OfflineRegion::Progress> updates;
+    region->start([&](const OfflineRegion::Progress &progress) {
+        updates.push_back(progress);
+    });
+
+    uv_run(loop, UV_RUN_DEFAULT);
+    region.reset();
+    run(fileSource);
+
+    ASSERT_FALSE(updates.empty());
+    const OfflineRegion::Progress &last = updates.back();
+    EXPECT_TRUE(last.done);
+
+    // The style, the TileJSON, the sprite image and JSON, one glyph range and five tiles. The
+    // sprite image, the glyphs and the four tiles at z1 don't exist.
+    EXPECT_EQ(10u, last.total);
+    EXPECT_EQ(10u, last.completed);
+    EXPECT_EQ(6u, last.failed);
+    EXPECT_EQ(1u, std::count_if(updates.begin(), updates.end(),
+                                [](const OfflineRegion::Progress &progress) { return progress.done; }));
+}
+
+TEST_F(OfflineRegionTest, PinnedEntriesAreNotEvicted) {
+    std::unique_ptr<FileSource> fileSource(new FileSource(loop, dir + "/cache.db"));
+    util::ptr<SQLiteStore> store = fileSource->getStore();
+
+    Response response;
+    response.code = 200;
+    response.data = std::string(1000, 'x');
+    store->put("http://example.com/pinned", ResourceType::Tile, response);
+    store->put("http://example.com/unpinned", ResourceType::Tile, response);
+    store->pin("http://example.com/pinned");
+
+    std::vector<std::string> unpinned;
+    store->getUnpinned({ "http://example.com/pinned", "http://example.com/unpinned", "http://example.com/missing" },
+                       [](std::vector<std::string> &&paths, void *ptr) {
+        *static_cast<std::vector<std::string> *>(ptr) = std::move(paths);
+    }, &unpinned);
+    uv_run(loop, UV_RUN_DEFAULT);
+    EXPECT_EQ((std::vector<std::string> { "http://example.com/unpinned", "http://example.com/missing" }), unpinned);
+
+    // Replacing a pinned entry keeps it pinned. The eviction runs after the next write.
+    store->put("http://example.com/pinned", ResourceType::Tile, response);
+    store->setMaximumSize(1);
+    store->flush();
+    uv_run(loop, UV_RUN_DEFAULT);
+
+    bool pinned = false, evicted = false;
+    store->get("http://example.com/pinned", [](std::unique_ptr<Response> &&res, void *ptr) {
+        *static_cast<bool *>(ptr) = bool(res);
+    }, &pinned);
+    store->get("http://example.com/unpinned", [](std::unique_ptr<Response> &&res, void *ptr) {
+        *static_cast<bool *>(ptr) = !res;
+    }, &evicted);
+    store.reset();
+    run(fileSource);
+
+    EXPECT_TRUE(pinned);
+    EXPECT_TRUE(evicted);
+}
@@ -0,0 +1,135 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource_archive.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/io.hpp>
+
+#include <uv.h>
+
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace mbgl;
+
+namespace {
+
+class ResourceArchiveTest : public ::testing::Test {
+protected:
+    void SetUp() {
+        char name[] = "/tmp/mbgl-archive-XXXXXX";
+        ASSERT_TRUE(mkdtemp(name));
+        dir = name;
+        loop = uv_loop_new();
+    }
+
+    void TearDown() {
+        uv_loop_delete(loop);
+        for (const char *file : { "/tile.pbf", "/archive.db" }) {
+            unlink((dir + file).c_str());
+        }
+        rmdir(dir.c_str());
+    }
+
+    // Requests the URL and returns how long it took in milliseconds.
+    uint64_t load(FileSource &fileSource, const std::string &url, Response &result) {
+        const uint64_t start = uv_now(loop);
+        uint64_t end = 0;
+        fileSource.request(ResourceType::Tile, url)->onload([&](const Response &res) {
+            end = uv_now(loop);
+            result = res;
+        });
+        uv_run(loop, UV_RUN_DEFAULT);
+        return end - start;
+    }
+
+    // Closes the FileSource's handles.
+    void close(std::unique_ptr<FileSource> &fileSource) {
+        fileSource.reset();
+        uv_run(loop, UV_RUN_DEFAULT);
+    }
+
+    std::string dir;
+    uv_loop_t *loop = nullptr;
+};
+
+}
+
+TEST_F(ResourceArchiveTest, RecordAndReplay) {
+    util::write_file(dir + "/tile.pbf", "tile");
+    const std::string url = "file://" + dir + "/tile.pbf";
+
+    std::unique_ptr<FileSource> fileSource(new FileSource(loop, ""));
+    fileSource->setArchive(std::make_shared<ResourceArchive>(dir + "/archive.db", ResourceArchive::Mode::Record));
+    Response res;
+    load(*fileSource, url, res);
+    EXPECT_EQ(200, res.code);
+    close(fileSource);
+
+    // The archive is written once the FileSource lets go of it.
+    unlink((dir + "/tile.pbf").c_str());
+
+    ResourceArchive::Profile profile;
+    profile.latency = ResourceArchive::Latency::None;
+    auto archive = std::make_shared<ResourceArchive>(dir + "/archive.db", ResourceArchive::Mode::Replay, profile);
+    EXPECT_EQ(1u, archive->size());
+
+    fileSource.reset(new FileSource(loop, ""));
+    fileSource->setArchive(archive);
+
+    load(*fileSource, url, res);
+    EXPECT_EQ(200, res.code);
+    EXPECT_EQ("tile", res.data.str());
+
+    load(*fileSource, "http://example.com/missing.pbf", res);
+    EXPECT_EQ(404, res.code);
+    close(fileSource);
+}
+
+TEST_F(ResourceArchiveTest, Latency) {
+    {
+        ResourceArchive archive(dir + "/archive.db", ResourceArchive::Mode::Record);
+        Response res;
+        res.code = 200;
+        res.data = std::string(2000, 'x');
+        archive.add("http://example.com/slow.pbf", res, util::now() - 40_milliseconds);
+    }
+
+    uint64_t delay = 0;
+
+    ResourceArchive recorded(dir + "/archive.db", ResourceArchive::Mode::Replay);
+    EXPECT_EQ(200, recorded.get("http://example.com/slow.pbf", delay)->code);
+    EXPECT_GE(delay, 40u);
+    EXPECT_LT(delay, 1000u);
+
+    ResourceArchive::Profile profile;
+    profile.latency = ResourceArchive::Latency::Simulated;
+    profile.delay = 30;
+    profile.bandwidth = 100000;
+    ResourceArchive simulated(dir + "/archive.db", ResourceArchive::Mode::Replay, profile);
+    EXPECT_EQ(2000u, simulated.get("http://example.com/slow.pbf", delay)->data.size());
+    EXPECT_EQ(50u, delay);
+
+    // The response is delivered through the loop after the delay.
+    std::unique_ptr<FileSource> fileSource(new FileSource(loop, ""));
+    fileSource->setArchive(std::make_shared<ResourceArchive>(dir + "/archive.db", ResourceArchive::Mode::Replay, profile));
+    Response res;
+    EXPECT_GE(load(*fileSource, "http://example.com/slow.pbf", res), 49u);
+    EXPECT_EQ(200, res.code);
+    close(fileSource);
+}
+
+TEST_F(ResourceArchiveTest, UnwritableArchive) {
+    Response response;
+    response.code = 200;
+    response.data = std::string("tile");
+
+    // The directory of the archive doesn't exist.
+    std::unique_ptr<ResourceArchive> archive(
+        new ResourceArchive(dir + "/missing/archive.db", ResourceArchive::Mode::Record));
+    archive->add("http://example.com/tile.pbf", response, util::now());
+    EXPECT_ANY_THROW(archive->save());
+
+    // Destroying the archive tries again, but only logs the error.
+    EXPECT_NO_THROW(archive.reset());
+}
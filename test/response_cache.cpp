@@ -0,0 +1,134 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/storage/response_cache.hpp>
+#include <mbgl/storage/sqlite_store.hpp>
+
+#include <uv.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace mbgl;
+
+namespace {
+
+Response makeResponse(const std::string &data, int64_t ttl = 3600) {
+    Response response;
+    response.code = 200;
+    response.expires = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() + ttl;
+    response.data = std::string(data);
+    return response;
+}
+
+}
+
+TEST(ResponseCache, SharesData) {
+    ResponseCache cache(1024 * 1024);
+    const Response response = makeResponse("tile");
+    cache.add("http://example.com/0/0/0.pbf", response);
+
+    std::unique_ptr<Response> cached = cache.get("http://example.com/0/0/0.pbf");
+    ASSERT_TRUE(bool(cached));
+    EXPECT_EQ(200, cached->code);
+    EXPECT_EQ(response.expires, cached->expires);
+    EXPECT_EQ(response.data.data(), cached->data.data());
+
+    EXPECT_FALSE(bool(cache.get("http://example.com/0/0/1.pbf")));
+}
+
+TEST(ResponseCache, SkipsExpiredAndFailedResponses) {
+    ResponseCache cache(1024 * 1024);
+
+    cache.add("http://example.com/expired", makeResponse("expired", -1));
+    EXPECT_FALSE(bool(cache.get("http://example.com/expired")));
+
+    Response notFound = makeResponse("");
+    notFound.code = 404;
+    cache.add("http://example.com/missing", notFound);
+    EXPECT_FALSE(bool(cache.get("http://example.com/missing")));
+
+    Response stale = makeResponse("stale");
+    stale.stale = true;
+    cache.add("http://example.com/stale", stale);
+    EXPECT_FALSE(bool(cache.get("http://example.com/stale")));
+
+    EXPECT_EQ(0u, cache.getBytes());
+}
+
+TEST(ResponseCache, EvictsLeastRecentlyUsed) {
+    const Response response = makeResponse(std::string(1000, 'x'));
+    ResponseCache cache(3 * 1000 + 3 * 200);
+
+    cache.add("http://example.com/a", response);
+    cache.add("http://example.com/b", response);
+    cache.add("http://example.com/c", response);
+
+    // Marks a as recently used, so b is evicted first.
+    EXPECT_TRUE(bool(cache.get("http://example.com/a")));
+    cache.add("http://example.com/d", response);
+
+    EXPECT_TRUE(bool(cache.get("http://example.com/a")));
+    EXPECT_FALSE(bool(cache.get("http://example.com/b")));
+    EXPECT_TRUE(bool(cache.get("http://example.com/c")));
+    EXPECT_TRUE(bool(cache.get("http://example.com/d")));
+    EXPECT_LE(cache.getBytes(), cache.getMaxBytes());
+
+    // Replacing an entry doesn't count it twice.
+    const size_t bytes = cache.getBytes();
+    cache.add("http://example.com/d", response);
+    EXPECT_EQ(bytes, cache.getBytes());
+
+    // Responses larger than the whole budget aren't cached.
+    cache.add("http://example.com/large", makeResponse(std::string(10000, 'x')));
+    EXPECT_FALSE(bool(cache.get("http://example.com/large")));
+
+    cache.setMaxBytes(0);
+    EXPECT_EQ(0u, cache.getBytes());
+    EXPECT_FALSE(bool(cache.get("http://example.com/a")));
+}
+
+TEST(ResponseCache, FileSourceHit) {
+    char name[] = "/tmp/mbgl-memory-XXXXXX";
+    ASSERT_TRUE(mkdtemp(name));
+    const std::string dir = name;
+    const std::string url = "http://example.invalid/0/0/0.pbf";
+    uv_loop_t *loop = uv_loop_new();
+
+    std::unique_ptr<FileSource> fileSource(new FileSource(loop, dir + "/cache.db"));
+    fileSource->getStore()->put(url, ResourceType::Tile, makeResponse("tile"));
+
+    // The first request is answered from the database and adds the response to the memory cache.
+    std::unique_ptr<Request> req = fileSource->request(ResourceType::Tile, url);
+    req->onload([&](const Response &res) {
+        req.reset();
+        EXPECT_EQ(200, res.code);
+    });
+    uv_run(loop, UV_RUN_DEFAULT);
+    EXPECT_FALSE(bool(req));
+
+    // A memory cache hit is delivered asynchronously, like any other response. Like a tile,
+    // the callback drops its request before it uses the response.
+    bool loaded = false;
+    req = fileSource->request(ResourceType::Tile, url);
+    req->onload([&](const Response &res) {
+        req.reset();
+        loaded = true;
+        EXPECT_EQ(200, res.code);
+        EXPECT_EQ("tile", res.data.str());
+    });
+    EXPECT_FALSE(loaded);
+    uv_run(loop, UV_RUN_DEFAULT);
+    EXPECT_TRUE(loaded);
+
+    fileSource.reset();
+    uv_run(loop, UV_RUN_DEFAULT);
+    uv_loop_delete(loop);
+    for (const char *file : { "/cache.db", "/cache.db-wal", "/cache.db-shm" }) {
+        unlink((dir + file).c_str());
+    }
+    rmdir(dir.c_str());
+}
@@ -0,0 +1,143 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/storage/sqlite_store.hpp>
+
+#include <uv.h>
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <unistd.h>
+
+using namespace mbgl;
+
+namespace {
+
+class SQLiteStoreTest : public ::testing::Test {
+protected:
+    void SetUp() {
+        char name[] = "/tmp/mbgl-store-XXXXXX";
+        ASSERT_TRUE(mkdtemp(name));
+        dir = name;
+        loop = uv_loop_new();
+    }
+
+    void TearDown() {
+        uv_loop_delete(loop);
+        for (const char *file : { "/cache.db", "/cache.db-wal", "/cache.db-shm" }) {
+            unlink((dir + file).c_str());
+        }
+        rmdir(dir.c_str());
+    }
+
+    // Runs the loop until all callbacks have finished, then closes the worker threads.
+    void run(std::unique_ptr<FileSource> &fileSource) {
+        uv_run(loop, UV_RUN_DEFAULT);
+        fileSource.reset();
+        uv_run(loop, UV_RUN_DEFAULT);
+    }
+
+    std::string dir;
+    uv_loop_t *loop = nullptr;
+};
+
+}
+
+TEST_F(SQLiteStoreTest, BucketsAreCounted) {
+    std::unique_ptr<FileSource> fileSource(new FileSource(loop, dir + "/cache.db"));
+    util::ptr<SQLiteStore> store = fileSource->getStore();
+
+    Response response;
+    response.code = 200;
+    response.data = std::string(1000, 'x');
+    store->put("http://example.com/pinned", ResourceType::Tile, response);
+    store->pin("http://example.com/pinned");
+
+    // Buckets don't compress as well as repeated characters.
+    std::mt19937 random(42);
+    std::string buckets(100000, '\0');
+    for (char &c : buckets) {
+        c = char(random());
+    }
+    store->putBuckets("http://example.com/pinned", "key", std::move(buckets));
+
+    // The buckets exceed the maximum size on their own, so they're evicted even though the
+    // tile is pinned.
+    store->setMaximumSize(50000);
+    store->flush();
+    uv_run(loop, UV_RUN_DEFAULT);
+
+    bool pinned = false, evicted = false;
+    store->get("http://example.com/pinned", [](std::unique_ptr<Response> &&res, void *ptr) {
+        *static_cast<bool *>(ptr) = bool(res);
+    }, &pinned);
+    store->getBuckets("http://example.com/pinned", "key", [](std::unique_ptr<std::string> &&data, void *ptr) {
+        *static_cast<bool *>(ptr) = !data;
+    }, &evicted);
+    store.reset();
+    run(fileSource);
+
+    EXPECT_TRUE(pinned);
+    EXPECT_TRUE(evicted);
+}
+
+TEST_F(SQLiteStoreTest, BucketsRequireCachedTile) {
+    std::unique_ptr<FileSource> fileSource(new FileSource(loop, dir + "/cache.db"));
+    util::ptr<SQLiteStore> store = fileSource->getStore();
+
+    Response response;
+    response.code = 200;
+    response.data = std::string(1000, 'x');
+    store->put("http://example.com/cached", ResourceType::Tile, response);
+    store->putBuckets("http://example.com/cached", "key", "buckets");
+
+    // Tiles from MBTiles or local files aren't in the HTTP cache, so nothing would evict them.
+    store->putBuckets("mbtiles://tiles.mbtiles/0/0/0.pbf", "key", "buckets");
+    store->flush();
+    uv_run(loop, UV_RUN_DEFAULT);
+
+    bool cached = false, skipped = false;
+    store->getBuckets("http://example.com/cached", "key", [](std::unique_ptr<std::string> &&data, void *ptr) {
+        *static_cast<bool *>(ptr) = bool(data);
+    }, &cached);
+    store->getBuckets("mbtiles://tiles.mbtiles/0/0/0.pbf", "key", [](std::unique_ptr<std::string> &&data, void *ptr) {
+        *static_cast<bool *>(ptr) = !data;
+    }, &skipped);
+    store.reset();
+    run(fileSource);
+
+    EXPECT_TRUE(cached);
+    EXPECT_TRUE(skipped);
+}
+
+TEST_F(SQLiteStoreTest, PinsAreVisibleToLookups) {
+    std::unique_ptr<FileSource> fileSource(new FileSource(loop, dir + "/cache.db"));
+    util::ptr<SQLiteStore> store = fileSource->getStore();
+
+    Response response;
+    response.code = 200;
+    response.data = std::string(1000, 'x');
+    std::vector<std::string> paths;
+    for (int i = 0; i < 50; i++) {
+        paths.push_back("http://example.com/" + std::to_string(i));
+        store->put(paths.back(), ResourceType::Tile, response);
+    }
+    store->flush();
+    uv_run(loop, UV_RUN_DEFAULT);
+
+    // Each lookup is started while the batch with the pin is still being committed.
+    std::vector<std::string> unpinned;
+    for (const std::string &path : paths) {
+        store->pin(path);
+        store->getUnpinned({ path }, [](std::vector<std::string> &&result, void *ptr) {
+            auto &all = *static_cast<std::vector<std::string> *>(ptr);
+            all.insert(all.end(), result.begin(), result.end());
+        }, &unpinned);
+    }
+    store.reset();
+    run(fileSource);
+
+    EXPECT_EQ(std::vector<std::string>(), unpinned);
+}
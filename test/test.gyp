@@ -48,6 +48,24 @@
         }]
       ]
     },
+    { 'target_name': 'earcut',
+      'product_name': 'test_earcut',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './earcut.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)'] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
     { 'target_name': 'enums',
       'product_name': 'test_enums',
       'type': 'executable',
@@ -215,12 +233,260 @@
         }]
       ]
     },
+    { 'target_name': 'mbtiles',
+      'product_name': 'test_mbtiles',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './mbtiles.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+        '<(platform_library)',
+      ],
+      'conditions': [
+        ['OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '<@(uv_cflags)', '<@(sqlite3_cflags)', '<@(zlib_cflags)' ],
+            'OTHER_LDFLAGS': [ '<@(ldflags)', '<@(zlib_ldflags)' ],
+          },
+        }, {
+          'cflags': [ '<@(uv_cflags)', '<@(sqlite3_cflags)', '<@(zlib_cflags)' ],
+          'libraries': [ '<@(ldflags)', '<@(zlib_ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'offline_region',
+      'product_name': 'test_offline_region',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './offline_region.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+        '<(platform_library)',
+      ],
+      'conditions': [
+        ['OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '<@(uv_cflags)', '<@(sqlite3_cflags)' ],
+            'OTHER_LDFLAGS': [ '<@(ldflags)' ],
+          },
+        }, {
+          'cflags': [ '<@(uv_cflags)', '<@(sqlite3_cflags)' ],
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'work_scheduler',
+      'product_name': 'test_work_scheduler',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './work_scheduler.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'conditions': [
+        ['OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '<@(uv_cflags)' ],
+            'OTHER_LDFLAGS': [ '<@(ldflags)' ],
+          },
+        }, {
+          'cflags': [ '<@(uv_cflags)' ],
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'sqlite_store',
+      'product_name': 'test_sqlite_store',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './sqlite_store.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+        '<(platform_library)',
+      ],
+      'conditions': [
+        ['OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '<@(uv_cflags)', '<@(sqlite3_cflags)' ],
+            'OTHER_LDFLAGS': [ '<@(ldflags)' ],
+          },
+        }, {
+          'cflags': [ '<@(uv_cflags)', '<@(sqlite3_cflags)' ],
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'response_cache',
+      'product_name': 'test_response_cache',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './response_cache.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+        '<(platform_library)',
+      ],
+      'conditions': [
+        ['OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '<@(uv_cflags)' ],
+            'OTHER_LDFLAGS': [ '<@(ldflags)' ],
+          },
+        }, {
+          'cflags': [ '<@(uv_cflags)' ],
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'compression',
+      'product_name': 'test_compression',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './compression.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'conditions': [
+        ['OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '<@(zlib_cflags)' ],
+            'OTHER_LDFLAGS': [ '<@(ldflags)', '<@(zlib_ldflags)' ],
+          },
+        }, {
+          'cflags': [ '<@(zlib_cflags)' ],
+          'libraries': [ '<@(ldflags)', '<@(zlib_ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'resource_archive',
+      'product_name': 'test_resource_archive',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './resource_archive.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+        '<(platform_library)',
+      ],
+      'conditions': [
+        ['OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '<@(uv_cflags)' ],
+            'OTHER_LDFLAGS': [ '<@(ldflags)' ],
+          },
+        }, {
+          'cflags': [ '<@(uv_cflags)' ],
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'glyph_store',
+      'product_name': 'test_glyph_store',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './glyph_store.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'glyph_atlas',
+      'product_name': 'test_glyph_atlas',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './glyph_atlas.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+        '../mapboxgl.gyp:mbgl-headless',
+      ],
+      'conditions': [
+        # add OpenGL libs
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(glfw3_ldflags)', '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(glfw3_ldflags)', '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'binpack',
+      'product_name': 'test_binpack',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './binpack.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)'] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'tile_cache',
+      'product_name': 'test_tile_cache',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './tile_cache.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+        '<(platform_library)',
+      ],
+      'conditions': [
+        # add libuv include path and OpenGL libs
+        ['OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '<@(uv_cflags)' ],
+            'OTHER_LDFLAGS': [ '<@(glfw3_ldflags)', '<@(ldflags)' ],
+          },
+        }, {
+          'cflags': [ '<@(uv_cflags)' ],
+          'libraries': [ '<@(glfw3_ldflags)', '<@(ldflags)' ],
+        }]
+      ]
+    },
     # Build all targets
     { 'target_name': 'test',
       'type': 'none',
       'dependencies': [
         'rotation_range',
         'clip_ids',
+        'earcut',
         'enums',
         'variant',
         'tile',
@@ -229,6 +495,17 @@
         'style_parser',
         'comparisons',
         'text_conversions',
+        'mbtiles',
+        'offline_region',
+        'response_cache',
+        'compression',
+        'resource_archive',
+        'glyph_store',
+        'glyph_atlas',
+        'binpack',
+        'sqlite_store',
+        'work_scheduler',
+        'tile_cache',
       ],
     }
   ]
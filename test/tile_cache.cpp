@@ -0,0 +1,127 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/map/map.hpp>
+#include <mbgl/map/tile_cache.hpp>
+#include <mbgl/map/tile_data.hpp>
+#include <mbgl/map/view.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+// The cache never renders its tiles, so the map doesn't need a GL context.
+class StubView : public View {
+public:
+    void swap() {}
+    void make_active() {}
+    void make_inactive() {}
+    void notify() {}
+    void notify_map_change(MapChange, timestamp) {}
+};
+
+// Tile data that claims to occupy a fixed number of bytes.
+class StubTileData : public TileData {
+public:
+    StubTileData(const Tile::ID &id_, Map &map_, size_t size_)
+        : TileData(id_, map_, nullptr), size(size_) {}
+
+    void parse() {}
+    void render(Painter &, util::ptr<StyleLayer>, const mat4 &) {}
+    bool hasData(StyleLayer const &) const { return false; }
+    size_t bytes() const { return size; }
+
+private:
+    const size_t size;
+};
+
+class TileCacheTest : public ::testing::Test {
+protected:
+    TileCacheTest() : map(view) {}
+
+    util::ptr<TileData> tile(int32_t x, size_t size) {
+        return std::make_shared<StubTileData>(Tile::ID(1, x, 0), map, size);
+    }
+
+    StubView view;
+    Map map;
+};
+
+}
+
+TEST_F(TileCacheTest, EvictsLeastRecentlyUsed) {
+    TileCache cache(300);
+    cache.add(Tile::ID(1, 0, 0), tile(0, 100));
+    cache.add(Tile::ID(1, 1, 0), tile(1, 100));
+    cache.add(Tile::ID(1, 2, 0), tile(2, 100));
+    EXPECT_EQ(300u, cache.getBytes());
+
+    cache.add(Tile::ID(1, 3, 0), tile(3, 150));
+    EXPECT_FALSE(cache.has(Tile::ID(1, 0, 0)));
+    EXPECT_FALSE(cache.has(Tile::ID(1, 1, 0)));
+    EXPECT_TRUE(cache.has(Tile::ID(1, 2, 0)));
+    EXPECT_TRUE(cache.has(Tile::ID(1, 3, 0)));
+    EXPECT_EQ(250u, cache.getBytes());
+}
+
+TEST_F(TileCacheTest, AddExisting) {
+    TileCache cache(300);
+    cache.add(Tile::ID(1, 0, 0), tile(0, 100));
+    cache.add(Tile::ID(1, 1, 0), tile(1, 100));
+
+    // The new data replaces the old one without being counted twice, and the tile becomes the
+    // most recently used one.
+    util::ptr<TileData> data = tile(0, 120);
+    cache.add(Tile::ID(1, 0, 0), data);
+    EXPECT_EQ(220u, cache.getBytes());
+
+    cache.add(Tile::ID(1, 2, 0), tile(2, 100));
+    EXPECT_TRUE(cache.has(Tile::ID(1, 0, 0)));
+    EXPECT_FALSE(cache.has(Tile::ID(1, 1, 0)));
+    EXPECT_EQ(data, cache.get(Tile::ID(1, 0, 0)));
+}
+
+TEST_F(TileCacheTest, GetRemoves) {
+    TileCache cache(300);
+    util::ptr<TileData> data = tile(0, 100);
+    cache.add(Tile::ID(1, 0, 0), data);
+
+    EXPECT_EQ(data, cache.get(Tile::ID(1, 0, 0)));
+    EXPECT_FALSE(cache.has(Tile::ID(1, 0, 0)));
+    EXPECT_EQ(0u, cache.getBytes());
+    EXPECT_EQ(nullptr, cache.get(Tile::ID(1, 0, 0)));
+}
+
+TEST_F(TileCacheTest, SetMaxBytes) {
+    TileCache cache(300);
+    cache.add(Tile::ID(1, 0, 0), tile(0, 100));
+    cache.add(Tile::ID(1, 1, 0), tile(1, 100));
+    cache.add(Tile::ID(1, 2, 0), tile(2, 100));
+
+    // Shrinking the budget evicts right away.
+    cache.setMaxBytes(150);
+    EXPECT_EQ(150u, cache.getMaxBytes());
+    EXPECT_EQ(100u, cache.getBytes());
+    EXPECT_FALSE(cache.has(Tile::ID(1, 0, 0)));
+    EXPECT_FALSE(cache.has(Tile::ID(1, 1, 0)));
+    EXPECT_TRUE(cache.has(Tile::ID(1, 2, 0)));
+
+    // Tiles that are larger than the whole budget aren't cached.
+    cache.add(Tile::ID(1, 3, 0), tile(3, 200));
+    EXPECT_FALSE(cache.has(Tile::ID(1, 3, 0)));
+    EXPECT_TRUE(cache.has(Tile::ID(1, 2, 0)));
+}
+
+TEST_F(TileCacheTest, Disabled) {
+    TileCache cache;
+    EXPECT_EQ(0u, cache.getMaxBytes());
+
+    cache.add(Tile::ID(1, 0, 0), tile(0, 100));
+    EXPECT_FALSE(cache.has(Tile::ID(1, 0, 0)));
+    EXPECT_EQ(0u, cache.getBytes());
+
+    cache.setMaxBytes(300);
+    cache.add(Tile::ID(1, 0, 0), tile(0, 100));
+    cache.setMaxBytes(0);
+    EXPECT_FALSE(cache.has(Tile::ID(1, 0, 0)));
+    EXPECT_EQ(0u, cache.getBytes());
+}
@@ -0,0 +1,175 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/util/work_scheduler.hpp>
+
+#include <uv.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+// Lets a thread wait until another one releases it, e.g. a worker thread until the test has
+// queued all of its requests.
+class Gate {
+public:
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return open; });
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            open = true;
+        }
+        condition.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool open = false;
+};
+
+class WorkSchedulerTest : public ::testing::Test {
+protected:
+    void SetUp() {
+        loop = uv_loop_new();
+    }
+
+    void TearDown() {
+        uv_loop_delete(loop);
+    }
+
+    // Occupies the only thread of a scheduler until the gate is released.
+    void block(util::WorkScheduler &scheduler, Gate &gate) {
+        scheduler.add(-1, [&gate] { gate.wait(); }, nullptr);
+    }
+
+    // Adds a request that appends the id to the order in which requests ran.
+    util::ptr<util::WorkRequest> add(util::WorkScheduler &scheduler, double priority, int id) {
+        return scheduler.add(priority, [this, id] { order.push_back(id); }, nullptr);
+    }
+
+    // Lets all requests finish, then lets the threads terminate. uv_run() only returns once
+    // the scheduler is gone, since it keeps the loop alive until then.
+    void finish(std::unique_ptr<util::WorkScheduler> &scheduler) {
+        uv_run(loop, UV_RUN_DEFAULT);
+        scheduler.reset();
+        uv_run(loop, UV_RUN_DEFAULT);
+    }
+
+    uv_loop_t *loop = nullptr;
+
+    // Only written by the single thread of the scheduler.
+    std::vector<int> order;
+};
+
+}
+
+TEST_F(WorkSchedulerTest, LowerPriorityRunsFirst) {
+    std::unique_ptr<util::WorkScheduler> scheduler(new util::WorkScheduler(loop, 1));
+    Gate gate;
+    block(*scheduler, gate);
+
+    add(*scheduler, 3, 3);
+    add(*scheduler, 1, 1);
+    add(*scheduler, 2, 2);
+    add(*scheduler, 1, 4); // Same priority; added later.
+    gate.release();
+    finish(scheduler);
+
+    EXPECT_EQ(std::vector<int>({ 1, 4, 2, 3 }), order);
+}
+
+TEST_F(WorkSchedulerTest, SetPriority) {
+    std::unique_ptr<util::WorkScheduler> scheduler(new util::WorkScheduler(loop, 1));
+    Gate gate;
+    block(*scheduler, gate);
+
+    add(*scheduler, 1, 1);
+    add(*scheduler, 2, 2);
+    util::ptr<util::WorkRequest> request = add(*scheduler, 3, 3);
+    request->setPriority(0);
+    EXPECT_EQ(0, request->getPriority());
+    gate.release();
+    finish(scheduler);
+
+    EXPECT_EQ(std::vector<int>({ 3, 1, 2 }), order);
+}
+
+TEST_F(WorkSchedulerTest, Cancel) {
+    std::unique_ptr<util::WorkScheduler> scheduler(new util::WorkScheduler(loop, 1));
+    Gate gate;
+    block(*scheduler, gate);
+
+    bool ran = false;
+    std::vector<bool> completed;
+    util::ptr<util::WorkRequest> canceled = scheduler->add(1, [&ran] { ran = true; },
+        [&completed](bool result) { completed.push_back(result); });
+    scheduler->add(2, [] {}, [&completed](bool result) { completed.push_back(result); });
+    canceled->cancel();
+    EXPECT_TRUE(canceled->isCanceled());
+    gate.release();
+    finish(scheduler);
+
+    EXPECT_FALSE(ran);
+    EXPECT_EQ(std::vector<bool>({ false, true }), completed);
+}
+
+TEST_F(WorkSchedulerTest, Parallel) {
+    std::unique_ptr<util::WorkScheduler> scheduler(new util::WorkScheduler(loop, 4));
+
+    std::atomic<int> count { 0 };
+    std::vector<std::function<void()>> tasks(100, [&count] { count++; });
+    scheduler->parallel(tasks);
+    EXPECT_EQ(100, count);
+
+    // Work callbacks may split their work as well, with all threads of the pool busy.
+    count = 0;
+    for (int i = 0; i < 4; i++) {
+        scheduler->add(0, [&scheduler, &tasks] { scheduler->parallel(tasks); }, nullptr);
+    }
+    finish(scheduler);
+    EXPECT_EQ(400, count);
+}
+
+TEST_F(WorkSchedulerTest, ParallelRethrows) {
+    std::unique_ptr<util::WorkScheduler> scheduler(new util::WorkScheduler(loop, 4));
+
+    std::atomic<int> count { 0 };
+    std::vector<std::function<void()>> tasks(20, [&count] { count++; });
+    tasks[7] = [] { throw std::runtime_error("task failed"); };
+    EXPECT_THROW(scheduler->parallel(tasks), std::runtime_error);
+
+    // The other tasks still ran.
+    EXPECT_EQ(19, count);
+    finish(scheduler);
+}
+
+TEST_F(WorkSchedulerTest, Destructor) {
+    std::unique_ptr<util::WorkScheduler> scheduler(new util::WorkScheduler(loop, 1));
+    Gate started, gate;
+
+    std::vector<bool> completed;
+    scheduler->add(-1, [&started, &gate] { started.release(); gate.wait(); },
+        [&completed](bool result) { completed.push_back(result); });
+    scheduler->add(0, [] {}, [&completed](bool result) { completed.push_back(result); });
+    started.wait();
+
+    // Queued requests are canceled; the loop keeps running until the request that had already
+    // started has finished and the thread has terminated.
+    scheduler.reset();
+    gate.release();
+    uv_run(loop, UV_RUN_DEFAULT);
+
+    ASSERT_EQ(2u, completed.size());
+    EXPECT_TRUE(completed[0]);
+    EXPECT_FALSE(completed[1]);
+}